@@ -84,7 +84,7 @@ static void reset_channel (struct channel *);
 static bool check_device_type (struct disk *);
 static void identify_ata_device (struct disk *);
 
-static void select_sector (struct disk *, disk_sector_t);
+static void select_sector (struct disk *, disk_sector_t, size_t);
 static void issue_pio_command (struct channel *, uint8_t command);
 static void input_sector (struct channel *, void *);
 static void output_sector (struct channel *, const void *);
@@ -211,47 +211,103 @@ disk_size (struct disk *d) {
    per-disk locking is unneeded. */
 void
 disk_read (struct disk *d, disk_sector_t sec_no, void *buffer) {
+	struct disk_iov iov = { buffer, 1 };
+
+	disk_readv (d, sec_no, &iov, 1);
+}
+
+/* Write sector SEC_NO to disk D from BUFFER, which must contain
+   DISK_SECTOR_SIZE bytes.  Returns after the disk has
+   acknowledged receiving the data.
+   Internally synchronizes accesses to disks, so external
+   per-disk locking is unneeded. */
+void
+disk_write (struct disk *d, disk_sector_t sec_no, const void *buffer) {
+	struct disk_iov iov = { (void *) buffer, 1 };
+
+	disk_writev (d, sec_no, &iov, 1);
+}
+
+/* Returns the total number of sectors in the IOV_CNT elements of
+   IOV, which must be between 1 and DISK_XFER_MAX. */
+static size_t
+iov_sectors (const struct disk_iov *iov, size_t iov_cnt) {
+	size_t sec_cnt = 0;
+	size_t i;
+
+	for (i = 0; i < iov_cnt; i++) {
+		ASSERT (iov[i].buf != NULL);
+		sec_cnt += iov[i].sec_cnt;
+	}
+	ASSERT (sec_cnt >= 1 && sec_cnt <= DISK_XFER_MAX);
+	return sec_cnt;
+}
+
+/* Reads consecutive sectors starting at SEC_NO from disk D into
+   the buffers described by the IOV_CNT elements of IOV, in order,
+   with a single ATA command.
+   Internally synchronizes accesses to disks, so external
+   per-disk locking is unneeded. */
+void
+disk_readv (struct disk *d, disk_sector_t sec_no,
+		const struct disk_iov *iov, size_t iov_cnt) {
 	struct channel *c;
+	size_t sec_cnt;
+	size_t i, j;
 
 	ASSERT (d != NULL);
-	ASSERT (buffer != NULL);
+	ASSERT (iov != NULL);
+	sec_cnt = iov_sectors (iov, iov_cnt);
 
 	c = d->channel;
 	lock_acquire (&c->lock);
-	select_sector (d, sec_no);
+	select_sector (d, sec_no, sec_cnt);
 	issue_pio_command (c, CMD_READ_SECTOR_RETRY);
-	sema_down (&c->completion_wait);
-	if (!wait_while_busy (d))
-		PANIC ("%s: disk read failed, sector=%"PRDSNu, d->name, sec_no);
-	input_sector (c, buffer);
-	d->read_cnt++;
+	for (i = 0; i < iov_cnt; i++)
+		for (j = 0; j < iov[i].sec_cnt; j++) {
+			/* The drive interrupts once per sector. */
+			sema_down (&c->completion_wait);
+			if (!wait_while_busy (d))
+				PANIC ("%s: disk read failed, sector=%"PRDSNu, d->name, sec_no);
+			input_sector (c, (uint8_t *) iov[i].buf + j * DISK_SECTOR_SIZE);
+		}
+	d->read_cnt += sec_cnt;
 	lock_release (&c->lock);
 }
 
-/* Write sector SEC_NO to disk D from BUFFER, which must contain
-   DISK_SECTOR_SIZE bytes.  Returns after the disk has
+/* Writes consecutive sectors starting at SEC_NO on disk D from
+   the buffers described by the IOV_CNT elements of IOV, in order,
+   with a single ATA command.  Returns after the disk has
    acknowledged receiving the data.
    Internally synchronizes accesses to disks, so external
    per-disk locking is unneeded. */
 void
-disk_write (struct disk *d, disk_sector_t sec_no, const void *buffer) {
+disk_writev (struct disk *d, disk_sector_t sec_no,
+		const struct disk_iov *iov, size_t iov_cnt) {
 	struct channel *c;
+	size_t sec_cnt;
+	size_t i, j;
 
 	ASSERT (d != NULL);
-	ASSERT (buffer != NULL);
+	ASSERT (iov != NULL);
+	sec_cnt = iov_sectors (iov, iov_cnt);
 
 	c = d->channel;
 	lock_acquire (&c->lock);
-	select_sector (d, sec_no);
+	select_sector (d, sec_no, sec_cnt);
 	issue_pio_command (c, CMD_WRITE_SECTOR_RETRY);
-	if (!wait_while_busy (d))
-		PANIC ("%s: disk write failed, sector=%"PRDSNu, d->name, sec_no);
-	output_sector (c, buffer);
-	sema_down (&c->completion_wait);
-	d->write_cnt++;
+	for (i = 0; i < iov_cnt; i++)
+		for (j = 0; j < iov[i].sec_cnt; j++) {
+			if (!wait_while_busy (d))
+				PANIC ("%s: disk write failed, sector=%"PRDSNu, d->name, sec_no);
+			output_sector (c, (uint8_t *) iov[i].buf + j * DISK_SECTOR_SIZE);
+			/* The drive interrupts once per sector. */
+			sema_down (&c->completion_wait);
+		}
+	d->write_cnt += sec_cnt;
 	lock_release (&c->lock);
 }
-
+
 /* Disk detection and identification. */
 
 static void print_ata_string (char *string, size_t size);
@@ -404,17 +460,18 @@ print_ata_string (char *string, size_t size) {
 }
 
 /* Selects device D, waiting for it to become ready, and then
-   writes SEC_NO to the disk's sector selection registers.  (We
-   use LBA mode.) */
+   writes SEC_NO and the sector count SEC_CNT to the disk's sector
+   selection registers.  (We use LBA mode.) */
 static void
-select_sector (struct disk *d, disk_sector_t sec_no) {
+select_sector (struct disk *d, disk_sector_t sec_no, size_t sec_cnt) {
 	struct channel *c = d->channel;
 
-	ASSERT (sec_no < d->capacity);
+	ASSERT (sec_cnt >= 1 && sec_cnt <= DISK_XFER_MAX);
+	ASSERT (sec_no + sec_cnt <= d->capacity);
 	ASSERT (sec_no < (1UL << 28));
 
 	select_device_wait (d);
-	outb (reg_nsect (c), 1);
+	outb (reg_nsect (c), sec_cnt == DISK_XFER_MAX ? 0 : sec_cnt);
 	outb (reg_lbal (c), sec_no);
 	outb (reg_lbam (c), sec_no >> 8);
 	outb (reg_lbah (c), (sec_no >> 16));
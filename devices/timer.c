@@ -7,6 +7,7 @@
 #include "threads/io.h"
 #include "threads/synch.h"
 #include "threads/thread.h"
+#include "intrinsic.h"
 
 /* See [8254] for hardware details of the 8254 timer chip. */
 
@@ -20,14 +21,82 @@
 /* Number of timer ticks since OS booted. */
 static int64_t ticks;
 
+/* Hierarchical timing wheel holding the armed timeouts.
+
+   The near wheel has one slot per tick for the next 256 ticks.
+   Each far wheel has 64 slots, each slot covering one full turn
+   of the wheel below it.  When the near wheel wraps, the due slot
+   of the next wheel up is "cascaded": its timeouts are re-filed
+   into lower wheels.  Arming and cancelling are O(1), and each
+   timeout is moved at most once per level before it expires.
+   Timeouts further out than the wheels reach are parked in the
+   last slot of the top wheel and re-filed when it comes due. */
+#define NEAR_BITS 8
+#define NEAR_SIZE (1 << NEAR_BITS)
+#define NEAR_MASK (NEAR_SIZE - 1)
+#define FAR_BITS 6
+#define FAR_SIZE (1 << FAR_BITS)
+#define FAR_MASK (FAR_SIZE - 1)
+#define FAR_LEVELS 4
+#define WHEEL_SPAN ((int64_t) 1 << (NEAR_BITS + FAR_LEVELS * FAR_BITS))
+
+static struct list near_wheel[NEAR_SIZE];
+static struct list far_wheel[FAR_LEVELS][FAR_SIZE];
+
+/* Next tick whose near slot has not been processed yet. */
+static int64_t wheel_ticks;
+
+/* One-shot (tickless) operation.
+
+   Time is kept in PIT input clocks ("counts") since boot.  The
+   PIT normally runs periodically in mode 2 and interrupts once
+   per tick.  When the CPU goes idle, or a thread sleeps for less
+   than a tick, the PIT is switched to mode 0 and programmed for
+   the next interesting deadline instead: the first tick that has
+   a timeout due, or the earliest sub-tick sleeper.  On each
+   interrupt the elapsed counts are read back and turned into
+   whole ticks, so timer_ticks() stays exact across skipped
+   ticks. */
+#define PIT_HZ 1193180
+#define SHOT_MIN 16             /* Shortest one-shot, in counts. */
+#define SHOT_MAX 60000          /* Longest one-shot, below the 16-bit wrap. */
+
+static uint16_t pit_count;      /* Counts per tick. */
+static bool oneshot;            /* PIT in one-shot mode? */
+static int64_t shot_base;       /* Count time the current countdown began. */
+static int64_t shot_len;        /* Length of the current countdown. */
+static int64_t tick_base;       /* Count time of the last tick boundary. */
+static bool cpu_idle;           /* Between timer_idle_enter() and _exit(). */
+
+/* Threads sleeping for less than a tick, ordered by deadline. */
+static struct list subtick_list;
+
+/* A thread waiting in timer_deadline_sleep(). */
+struct subtick_sleeper {
+	struct list_elem elem;      /* Element in subtick_list. */
+	int64_t deadline;           /* Count time to wake at. */
+	struct thread *thread;      /* Sleeping thread. */
+};
+
 /* Number of loops per timer tick.
    Initialized by timer_calibrate(). */
 static unsigned loops_per_tick;
 
+/* Time-stamp counter cycles per microsecond.
+   Initialized by timer_calibrate(). */
+static uint64_t tsc_per_us;
+
 static intr_handler_func timer_interrupt;
 static bool too_many_loops (unsigned loops);
 static void busy_wait (int64_t loops);
 static void real_time_sleep (int64_t num, int32_t denom);
+static void wheel_add (struct timeout *);
+static void wheel_run (int64_t now);
+static int64_t wheel_quiet_ticks (int64_t limit);
+static int64_t clock_now (void);
+static void clock_advance (int64_t now);
+static void timer_program (int64_t now);
+static void timer_deadline_sleep (int64_t counts);
 
 /* Sets up the 8254 Programmable Interval Timer (PIT) to
    interrupt PIT_FREQ times per second, and registers the
@@ -36,12 +105,24 @@ void
 timer_init (void) {
 	/* 8254 input frequency divided by TIMER_FREQ, rounded to
 	   nearest. */
-	uint16_t count = (1193180 + TIMER_FREQ / 2) / TIMER_FREQ;
+	uint16_t count = (PIT_HZ + TIMER_FREQ / 2) / TIMER_FREQ;
 
 	outb (0x43, 0x34);    /* CW: counter 0, LSB then MSB, mode 2, binary. */
 	outb (0x40, count & 0xff);
 	outb (0x40, count >> 8);
 
+	pit_count = count;
+	oneshot = false;
+	shot_base = tick_base = 0;
+	shot_len = count;
+	list_init (&subtick_list);
+
+	for (int i = 0; i < NEAR_SIZE; i++)
+		list_init (&near_wheel[i]);
+	for (int level = 0; level < FAR_LEVELS; level++)
+		for (int i = 0; i < FAR_SIZE; i++)
+			list_init (&far_wheel[level][i]);
+
 	intr_register_ext (0x20, timer_interrupt, "8254 Timer");
 }
 
@@ -68,6 +149,26 @@ timer_calibrate (void) {
 			loops_per_tick |= test_bit;
 
 	printf ("%'"PRIu64" loops/s.\n", (uint64_t) loops_per_tick * TIMER_FREQ);
+
+	/* Measure the time-stamp counter over one whole tick. */
+	int64_t start = ticks;
+	uint64_t tsc;
+	while (ticks == start)
+		barrier ();
+	tsc = rdtsc ();
+	start = ticks;
+	while (ticks == start)
+		barrier ();
+	tsc_per_us = (rdtsc () - tsc) * TIMER_FREQ / (1000 * 1000);
+	if (tsc_per_us == 0)
+		tsc_per_us = 1;
+}
+
+/* Converts CYCLES of the time-stamp counter to microseconds.
+   Returns 0 before timer_calibrate() has run. */
+uint64_t
+timer_tsc_to_us (uint64_t cycles) {
+	return tsc_per_us != 0 ? cycles / tsc_per_us : 0;
 }
 
 /* Returns the number of timer ticks since the OS booted. */
@@ -95,7 +196,57 @@ timer_sleep (int64_t ticks) {
 	ASSERT (intr_get_level () == INTR_ON);
 	// while (timer_elapsed (start) < ticks)
 	// 	thread_yield ();
-	thread_sleep(start, ticks);
+	if (ticks > 0)
+		thread_sleep(start, ticks);
+}
+
+/* Initializes timeout T to call FUNC with AUX when it expires.
+   FUNC runs in the timer interrupt handler, with interrupts off,
+   so it must not sleep. */
+void
+timeout_init (struct timeout *t, timeout_func *func, void *aux) {
+	ASSERT (t != NULL);
+	ASSERT (func != NULL);
+
+	t->func = func;
+	t->aux = aux;
+	t->expires = 0;
+	t->armed = false;
+}
+
+/* Arms timeout T to fire at timer tick EXPIRES, as returned by
+   timer_ticks().  A tick that has already passed fires on the
+   next timer interrupt.  T must not already be armed. */
+void
+timeout_arm (struct timeout *t, int64_t expires) {
+	enum intr_level old_level = intr_disable ();
+
+	ASSERT (!t->armed);
+	t->expires = expires;
+	t->armed = true;
+	wheel_add (t);
+	intr_set_level (old_level);
+}
+
+/* Disarms timeout T.  Returns true if T was armed, false if it
+   had already fired or was never armed. */
+bool
+timeout_cancel (struct timeout *t) {
+	enum intr_level old_level = intr_disable ();
+	bool was_armed = t->armed;
+
+	if (was_armed) {
+		list_remove (&t->elem);
+		t->armed = false;
+	}
+	intr_set_level (old_level);
+	return was_armed;
+}
+
+/* Returns true if timeout T is armed and has not fired yet. */
+bool
+timeout_pending (const struct timeout *t) {
+	return t->armed;
 }
 
 /* Suspends execution for approximately MS milliseconds. */
@@ -122,12 +273,303 @@ timer_print_stats (void) {
 	printf ("Timer: %"PRId64" ticks\n", timer_ticks ());
 }
 
+/* Called by the idle thread, with interrupts off, right before
+   it halts.  Stretches the current countdown to the next tick
+   that actually has work to do. */
+void
+timer_idle_enter (void) {
+	ASSERT (intr_get_level () == INTR_OFF);
+
+	/* The 4.4BSD scheduler must see every tick. */
+	if (thread_mlfqs)
+		return;
+
+	cpu_idle = true;
+	timer_program (clock_now ());
+}
+
+/* Called by the idle thread, with interrupts off, after it wakes
+   up.  If an interrupt other than the timer ended the idle
+   period, credits the ticks that passed meanwhile and restores
+   the countdown to the next tick boundary. */
+void
+timer_idle_exit (void) {
+	int64_t now;
+
+	ASSERT (intr_get_level () == INTR_OFF);
+
+	if (!cpu_idle)
+		return;
+	cpu_idle = false;
+	if (!oneshot)
+		return;
+
+	now = clock_now ();
+	while (now - tick_base >= pit_count) {
+		/* No timeout is due inside an idle stretch, so running
+		   the wheel only advances it. */
+		tick_base += pit_count;
+		ticks++;
+		thread_idle_tick ();
+	}
+	wheel_run (ticks);
+	timer_program (now);
+}
+
+/* Reads the current value of PIT counter 0. */
+static uint16_t
+pit_read (void) {
+	uint8_t lo, hi;
+
+	outb (0x43, 0x00);    /* CW: latch counter 0. */
+	lo = inb (0x40);
+	hi = inb (0x40);
+	return lo | (hi << 8);
+}
+
+/* Returns true if the timer interrupt is raised but has not been
+   serviced yet, by reading the master PIC's IRR. */
+static bool
+pit_irq_pending (void) {
+	outb (0x20, 0x0a);    /* OCW3: read IRR. */
+	return inb (0x20) & 1;
+}
+
+/* Returns the current time in PIT counts since boot. */
+static int64_t
+clock_now (void) {
+	int64_t elapsed;
+	uint16_t cur;
+
+	ASSERT (intr_get_level () == INTR_OFF);
+
+	if (oneshot) {
+		/* Mode 0 counts SHOT_LEN down to 0, then keeps wrapping
+		   from 0xffff. */
+		cur = pit_read ();
+		elapsed = cur <= shot_len ? shot_len - cur : shot_len + 0x10000 - cur;
+	} else {
+		/* Mode 2 reloads at the end of every period; a period that
+		   ended but was not serviced yet shows up in the IRR. */
+		bool pending;
+		do {
+			pending = pit_irq_pending ();
+			cur = pit_read ();
+		} while (pending != pit_irq_pending ());
+		elapsed = pit_count - cur + (pending ? pit_count : 0);
+	}
+	return shot_base + elapsed;
+}
+
+/* Credits every tick boundary up to NOW and runs the timeouts
+   and sub-tick sleepers that came due. */
+static void
+clock_advance (int64_t now) {
+	shot_base = now;
+	while (now - tick_base >= pit_count) {
+		tick_base += pit_count;
+		ticks++;
+		thread_tick ();
+	}
+	wheel_run (ticks);
+
+	while (!list_empty (&subtick_list)) {
+		struct subtick_sleeper *s = list_entry (list_front (&subtick_list),
+				struct subtick_sleeper, elem);
+		if (s->deadline > now)
+			break;
+		list_pop_front (&subtick_list);
+		thread_unblock (s->thread);
+	}
+}
+
+/* Programs the PIT for the next event after NOW: the next tick
+   boundary, or a later one if the CPU is idle and nothing is due
+   before it, or an earlier sub-tick deadline. */
+static void
+timer_program (int64_t now) {
+	int64_t next_tick = tick_base + pit_count;
+	int64_t next = next_tick;
+	int64_t len;
+
+	ASSERT (intr_get_level () == INTR_OFF);
+
+	if (cpu_idle) {
+		int64_t max_ticks = (now + SHOT_MAX - tick_base) / pit_count;
+		next = tick_base + wheel_quiet_ticks (max_ticks) * pit_count;
+	}
+	if (!list_empty (&subtick_list)) {
+		struct subtick_sleeper *s = list_entry (list_front (&subtick_list),
+				struct subtick_sleeper, elem);
+		if (s->deadline < next)
+			next = s->deadline;
+	}
+
+	if (next == next_tick) {
+		/* Periodic mode already interrupts at the next tick. */
+		if (!oneshot)
+			return;
+
+		/* Back on the tick grid: let the PIT run periodically
+		   again.  Only the handler may do this, since it knows no
+		   one-shot interrupt is still pending. */
+		if (intr_context () && now - tick_base < SHOT_MIN) {
+			outb (0x43, 0x34);    /* CW: counter 0, LSB then MSB, mode 2, binary. */
+			outb (0x40, pit_count & 0xff);
+			outb (0x40, pit_count >> 8);
+			oneshot = false;
+			tick_base = shot_base = now;
+			shot_len = pit_count;
+			return;
+		}
+	}
+
+	len = next - now;
+	if (len < SHOT_MIN)
+		len = SHOT_MIN;
+	if (len > SHOT_MAX)
+		len = SHOT_MAX;
+	outb (0x43, 0x30);    /* CW: counter 0, LSB then MSB, mode 0, binary. */
+	outb (0x40, len & 0xff);
+	outb (0x40, len >> 8);
+	oneshot = true;
+	shot_base = now;
+	shot_len = len;
+}
+
+/* Orders sub-tick sleepers by deadline. */
+static bool
+deadline_less (const struct list_elem *a_, const struct list_elem *b_,
+		void *aux UNUSED) {
+	const struct subtick_sleeper *a = list_entry (a_, struct subtick_sleeper, elem);
+	const struct subtick_sleeper *b = list_entry (b_, struct subtick_sleeper, elem);
+	return a->deadline < b->deadline;
+}
+
+/* Blocks the current thread for COUNTS PIT clocks, less than a
+   tick, by programming a one-shot deadline. */
+static void
+timer_deadline_sleep (int64_t counts) {
+	struct subtick_sleeper s;
+	enum intr_level old_level;
+	int64_t now;
+
+	old_level = intr_disable ();
+	now = clock_now ();
+	s.deadline = now + counts;
+	s.thread = thread_current ();
+	list_insert_ordered (&subtick_list, &s.elem, deadline_less, NULL);
+	if (s.deadline < shot_base + shot_len)
+		timer_program (now);
+	thread_block ();
+	intr_set_level (old_level);
+}
+
 /* Timer interrupt handler. */
 static void
 timer_interrupt (struct intr_frame *args UNUSED) {
-	ticks++;
-	thread_tick ();
-	thread_wake(ticks);
+	int64_t now = oneshot ? clock_now () : shot_base + pit_count;
+
+	clock_advance (now);
+	timer_program (now);
+}
+
+/* Returns the number of ticks, counted from the last credited
+   tick and at most LIMIT, until the first tick whose near slot
+   may hold a due timeout.  A near-wheel wrap counts as busy,
+   since the cascade can bring timeouts due right then. */
+static int64_t
+wheel_quiet_ticks (int64_t limit) {
+	int64_t n;
+
+	for (n = 1; n < limit; n++) {
+		int64_t tick = ticks + n;
+		if ((tick & NEAR_MASK) == 0 || !list_empty (&near_wheel[tick & NEAR_MASK]))
+			break;
+	}
+	return n;
+}
+
+/* Files armed timeout T into the wheel slot matching its expiry
+   relative to wheel_ticks. */
+static void
+wheel_add (struct timeout *t) {
+	int64_t expires = t->expires;
+	int64_t delta = expires - wheel_ticks;
+	struct list *slot;
+
+	ASSERT (intr_get_level () == INTR_OFF);
+
+	if (delta < 0) {
+		/* Already due; fire with the next processed slot. */
+		slot = &near_wheel[wheel_ticks & NEAR_MASK];
+	} else if (delta < NEAR_SIZE) {
+		slot = &near_wheel[expires & NEAR_MASK];
+	} else {
+		int level, shift;
+
+		if (delta >= WHEEL_SPAN) {
+			/* Beyond reach: park it at the furthest slot. */
+			expires = wheel_ticks + WHEEL_SPAN - 1;
+			delta = WHEEL_SPAN - 1;
+		}
+		for (level = 0; level < FAR_LEVELS - 1; level++)
+			if (delta < (int64_t) 1 << (NEAR_BITS + (level + 1) * FAR_BITS))
+				break;
+		shift = NEAR_BITS + level * FAR_BITS;
+		slot = &far_wheel[level][(expires >> shift) & FAR_MASK];
+	}
+	list_push_back (slot, &t->elem);
+}
+
+/* Re-files every timeout in slot INDEX of far wheel LEVEL into
+   the lower wheels.  Returns INDEX. */
+static int
+wheel_cascade (int level, int index) {
+	struct list *slot = &far_wheel[level][index];
+	struct list moved;
+
+	list_init (&moved);
+	if (!list_empty (slot))
+		list_splice (list_end (&moved), list_begin (slot), list_end (slot));
+	while (!list_empty (&moved))
+		wheel_add (list_entry (list_pop_front (&moved), struct timeout, elem));
+	return index;
+}
+
+/* Fires every timeout due at or before tick NOW. */
+static void
+wheel_run (int64_t now) {
+	ASSERT (intr_get_level () == INTR_OFF);
+
+	while (wheel_ticks <= now) {
+		int index = wheel_ticks & NEAR_MASK;
+		struct list due;
+
+		/* When the near wheel wraps, pull the next turn down from
+		   the far wheels, carrying into higher levels as each of
+		   them wraps in turn. */
+		if (index == 0) {
+			for (int level = 0; level < FAR_LEVELS; level++) {
+				int shift = NEAR_BITS + level * FAR_BITS;
+				if (wheel_cascade (level, (wheel_ticks >> shift) & FAR_MASK) != 0)
+					break;
+			}
+		}
+
+		list_init (&due);
+		if (!list_empty (&near_wheel[index]))
+			list_splice (list_end (&due), list_begin (&near_wheel[index]),
+					list_end (&near_wheel[index]));
+		wheel_ticks++;
+
+		while (!list_empty (&due)) {
+			struct timeout *t =
+				list_entry (list_pop_front (&due), struct timeout, elem);
+			t->armed = false;
+			t->func (t->aux);
+		}
+	}
 }
 
 /* Returns true if LOOPS iterations waits for more than one timer
@@ -179,10 +621,17 @@ real_time_sleep (int64_t num, int32_t denom) {
 		   processes. */
 		timer_sleep (ticks);
 	} else {
-		/* Otherwise, use a busy-wait loop for more accurate
-		   sub-tick timing.  We scale the numerator and denominator
-		   down by 1000 to avoid the possibility of overflow. */
+		/* Otherwise, sleep until a one-shot PIT deadline for
+		   accurate sub-tick timing.  Waits too short to be worth
+		   reprogramming the PIT use a busy-wait loop.  We scale the
+		   numerator and denominator down by 1000 to avoid the
+		   possibility of overflow. */
+		int64_t counts = num * PIT_HZ / denom;
+
 		ASSERT (denom % 1000 == 0);
-		busy_wait (loops_per_tick * num / 1000 * TIMER_FREQ / (denom / 1000));
+		if (counts >= SHOT_MIN)
+			timer_deadline_sleep (counts);
+		else
+			busy_wait (loops_per_tick * num / 1000 * TIMER_FREQ / (denom / 1000));
 	}
 }
@@ -98,10 +98,12 @@ dir_lookup (const struct dir *dir, const char *name,
 	ASSERT (dir != NULL);
 	ASSERT (name != NULL);
 
+	rwlock_acquire_read (&dir->inode->dir_lock);
 	if (lookup (dir, name, &e, NULL))
 		*inode = inode_open (e.inode_sector);
 	else
 		*inode = NULL;
+	rwlock_release_read (&dir->inode->dir_lock);
 
 	return *inode != NULL;
 }
@@ -125,6 +127,8 @@ dir_add (struct dir *dir, const char *name, disk_sector_t inode_sector) {
 	if (*name == '\0' || strlen (name) > NAME_MAX)
 		return false;
 
+	rwlock_acquire_write (&dir->inode->dir_lock);
+
 	/* Check that NAME is not in use. */
 	if (lookup (dir, name, NULL, NULL))
 		goto done;
@@ -148,6 +152,7 @@ dir_add (struct dir *dir, const char *name, disk_sector_t inode_sector) {
 	success = inode_write_at (dir->inode, &e, sizeof e, ofs) == sizeof e;
 
 done:
+	rwlock_release_write (&dir->inode->dir_lock);
 	return success;
 }
 
@@ -166,7 +171,9 @@ dir_remove (struct dir *dir, const char *name) {
 
 	// ".", ".." 파일 리턴
     if(!strcmp(name, ".") || !strcmp(name, ".."))
-        goto done;
+        return false;
+
+	rwlock_acquire_write (&dir->inode->dir_lock);
 
 	/* Find directory entry. */
 	if (!lookup (dir, name, &e, &ofs))
@@ -190,6 +197,7 @@ dir_remove (struct dir *dir, const char *name) {
 	success = true;
 
 done:
+	rwlock_release_write (&dir->inode->dir_lock);
 	inode_close (inode);
 	return success;
 }
@@ -200,15 +208,19 @@ done:
 bool
 dir_readdir (struct dir *dir, char name[NAME_MAX + 1]) {
 	struct dir_entry e;
+	bool found = false;
 
+	rwlock_acquire_read (&dir->inode->dir_lock);
 	while (inode_read_at (dir->inode, &e, sizeof e, dir->pos) == sizeof e) {
 		dir->pos += sizeof e;
 		if (e.in_use) {
 			strlcpy (name, e.name, NAME_MAX + 1);
-			return true;
+			found = true;
+			break;
 		}
 	}
-	return false;
+	rwlock_release_read (&dir->inode->dir_lock);
+	return found;
 }
 
 /*project4 추가*/
@@ -23,7 +23,7 @@ struct fat_fs {
 	unsigned int fat_length; //파일 시스템에 많은 클러스터를 저장
 	disk_sector_t data_start; //파일을 저장할 수 있는 섹터를 저장
 	cluster_t last_clst;
-	struct lock write_lock;
+	struct lock write_lock;        /* Guards allocation in fat. */
 };
 
 static struct fat_fs *fat_fs;
@@ -36,6 +36,7 @@ fat_init (void) {
 	fat_fs = calloc (1, sizeof (struct fat_fs));
 	if (fat_fs == NULL)
 		PANIC ("FAT init failed");
+	lock_init (&fat_fs->write_lock);
 
 	// Read boot sector from the disk
 	unsigned int *bounce = malloc (DISK_SECTOR_SIZE);
@@ -172,27 +173,28 @@ cluster_t
 fat_create_chain (cluster_t clst) {
 	/* TODO: Your code goes here. */
 	cluster_t i = 2;
-	while (fat_get(i) !=0 && i<fat_fs->fat_length)
+
+	lock_acquire (&fat_fs->write_lock);
+	while (i<fat_fs->fat_length && fat_get(i) !=0)
 	{
 		++i;
 	}
 
 	if (i==fat_fs->fat_length){ //FAT가 가득 찼다면
+		lock_release (&fat_fs->write_lock);
 		return 0;
 	}
 
 	fat_put(i, EOChain); //fat안의 값 업데이트
 	
-	if(clst == 0){ //새로운 체인 생성
-		return i;
-	}
-
-	while(fat_get(clst) != EOChain){
-		clst = fat_get(clst);
+	if(clst != 0){ //기존 체인 끝에 연결
+		while(fat_get(clst) != EOChain){
+			clst = fat_get(clst);
+		}
+		fat_put(clst,i);
 	}
-	fat_put(clst,i);
+	lock_release (&fat_fs->write_lock);
 	return i;
-	
 }
 
 /* Remove the chain of clusters starting from CLST.
@@ -201,6 +203,8 @@ void
 fat_remove_chain (cluster_t clst, cluster_t pclst) {
 	/* TODO: Your code goes here. */
 	cluster_t next;
+
+	lock_acquire (&fat_fs->write_lock);
 	while(fat_fs->fat[clst] != EOChain){
 		next = fat_fs->fat[clst];
 		fat_fs->fat[clst] = 0;
@@ -209,6 +213,7 @@ fat_remove_chain (cluster_t clst, cluster_t pclst) {
 	if(pclst != 0){
 		fat_fs->fat[pclst] = EOChain;
 	}
+	lock_release (&fat_fs->write_lock);
 }
 
 /* Update a value in the FAT table. */
@@ -86,6 +86,17 @@ file_read_at (struct file *file, void *buffer, off_t size, off_t file_ofs) {
 	return inode_read_at (file->inode, buffer, size, file_ofs);
 }
 
+/* Reads CNT pages of FILE, starting at offset FILE_OFS, which must
+ * be a multiple of DISK_SECTOR_SIZE, into the page-sized buffers
+ * PAGES, zeroing whatever lies past the end of the file.
+ * Returns the number of bytes read from the file.
+ * The file's current position is unaffected. */
+off_t
+file_read_pages (struct file *file, void **pages, size_t cnt,
+		off_t file_ofs) {
+	return inode_read_pages (file->inode, pages, cnt, file_ofs);
+}
+
 /* Writes SIZE bytes from BUFFER into FILE,
  * starting at the file's current position.
  * Returns the number of bytes actually written,
@@ -7,6 +7,7 @@
 #include "filesys/free-map.h"
 #include "threads/malloc.h"
 #include "filesys/fat.h"
+#include "threads/vaddr.h"
 
 
 /* Identifies an inode. */
@@ -54,10 +55,14 @@ byte_to_sector (const struct inode *inode, off_t pos) {
  * returns the same `struct inode'. */
 static struct list open_inodes;
 
+/* Guards open_inodes and the open_cnt of its members. */
+static struct lock open_inodes_lock;
+
 /* Initializes the inode module. */
 void
 inode_init (void) {
 	list_init (&open_inodes);
+	lock_init (&open_inodes_lock);
 }
 
 /* Initializes an inode with LENGTH bytes of data and
@@ -154,39 +159,74 @@ inode_open (disk_sector_t sector) {
 	struct list_elem *e;
 	struct inode *inode;
 
+	lock_acquire (&open_inodes_lock);
+
 	/* Check whether this inode is already open. */
 	for (e = list_begin (&open_inodes); e != list_end (&open_inodes);
 			e = list_next (e)) {
 		inode = list_entry (e, struct inode, elem);
 		if (inode->sector == sector) {
-			inode_reopen (inode);
+			inode->open_cnt++;
+			lock_release (&open_inodes_lock);
+
+			/* Wait until whoever opened it first has read it in. */
+			rwlock_acquire_read (&inode->rwlock);
+			rwlock_release_read (&inode->rwlock);
 			return inode; 
 		}
 	}
 
 	/* Allocate memory. */
 	inode = malloc (sizeof *inode);
-	if (inode == NULL)
+	if (inode == NULL) {
+		lock_release (&open_inodes_lock);
 		return NULL;
+	}
 
-	/* Initialize. */
+	/* Initialize.  The inode is published before it is read from
+	 * disk, holding its rwlock so that other openers wait for the
+	 * read without keeping open_inodes locked. */
 	list_push_front (&open_inodes, &inode->elem);
 	inode->sector = sector;
 	inode->open_cnt = 1;
 	inode->deny_write_cnt = 0;
 	inode->removed = false;
+	rwlock_init (&inode->rwlock);
+	rwlock_init (&inode->dir_lock);
+	rwlock_acquire_write (&inode->rwlock);
+	lock_release (&open_inodes_lock);
+
 	disk_read (filesys_disk, cluster_to_sector(inode->sector), &inode->data);
+	rwlock_release_write (&inode->rwlock);
 	return inode;
 }
 
 /* Reopens and returns INODE. */
 struct inode *
 inode_reopen (struct inode *inode) {
-	if (inode != NULL)
+	if (inode != NULL) {
+		lock_acquire (&open_inodes_lock);
 		inode->open_cnt++;
+		lock_release (&open_inodes_lock);
+	}
 	return inode;
 }
 
+/* Drops a reference to INODE.  Returns true if it was the last
+ * one, in which case INODE is no longer in open_inodes and the
+ * caller must free it. */
+static bool
+inode_put (struct inode *inode) {
+	bool last;
+
+	lock_acquire (&open_inodes_lock);
+	last = --inode->open_cnt == 0;
+	if (last)
+		list_remove (&inode->elem);
+	lock_release (&open_inodes_lock);
+	return last;
+}
+
 /* Returns INODE's inode number. */
 disk_sector_t
 inode_get_inumber (const struct inode *inode) {
@@ -205,10 +245,7 @@ inode_close (struct inode *inode) {
 		return;
 
 	/* Release resources if this was the last opener. */
-	if (--inode->open_cnt == 0) {
-		/* Remove from inode list and release lock. */
-		list_remove (&inode->elem);
-
+	if (inode_put (inode)) {
 		/* Deallocate blocks if removed. */
 		if (inode->removed) {
 			fat_remove_chain (inode->sector, 0);
@@ -225,10 +262,7 @@ inode_close (struct inode *inode) {
 		return;
 
 	/* Release resources if this was the last opener. */
-	if (--inode->open_cnt == 0) {
-		/* Remove from inode list and release lock. */
-		list_remove (&inode->elem);
-
+	if (inode_put (inode)) {
 		/* Deallocate blocks if removed. */
 		if (inode->removed) {
 			free_map_release (inode->sector, 1);
@@ -245,18 +279,35 @@ inode_close (struct inode *inode) {
 void
 inode_remove (struct inode *inode) {
 	ASSERT (inode != NULL);
+	rwlock_acquire_write (&inode->rwlock);
 	inode->removed = true;
+	rwlock_release_write (&inode->rwlock);
 }
 
 /* Reads SIZE bytes from INODE into BUFFER, starting at position OFFSET.
  * Returns the number of bytes actually read, which may be less
- * than SIZE if an error occurs or end of file is reached. */
+ * than SIZE if an error occurs or end of file is reached.
+ *
+ * A user BUFFER is filled from a kernel copy of the whole request
+ * after INODE's rwlock is released, because a page fault on BUFFER
+ * may have to read or write back a page of INODE itself. */
 off_t
 inode_read_at (struct inode *inode, void *buffer_, off_t size, off_t offset) {
 	uint8_t *buffer = buffer_;
 	off_t bytes_read = 0;
 	uint8_t *bounce = NULL;
 
+	if (size > 0 && is_user_vaddr (buffer)) {
+		uint8_t *copy = malloc (size);
+		if (copy == NULL)
+			return 0;
+		bytes_read = inode_read_at (inode, copy, size, offset);
+		memcpy (buffer, copy, bytes_read);
+		free (copy);
+		return bytes_read;
+	}
+
+	rwlock_acquire_read (&inode->rwlock);
 	while (size > 0) {
 		/* Disk sector to read, starting byte offset within sector. */
 		disk_sector_t sector_idx = byte_to_sector (inode, offset);
@@ -292,25 +343,192 @@ inode_read_at (struct inode *inode, void *buffer_, off_t size, off_t offset) {
 		offset += chunk_size;
 		bytes_read += chunk_size;
 	}
+	rwlock_release_read (&inode->rwlock);
 	free (bounce);
 
 	return bytes_read;
 }
 
+/* Reads CNT pages of INODE, starting at OFFSET, which must be
+ * sector-aligned, into the page-sized buffers PAGES.  Runs of
+ * consecutive sectors go to the disk as one request each, however
+ * the pages are laid out in memory.  Bytes past the end of the
+ * file read as zeros.  Returns the number of bytes read from the
+ * file. */
+off_t
+inode_read_pages (struct inode *inode, void **pages, size_t cnt,
+		off_t offset) {
+	struct disk_iov iov[DISK_XFER_MAX / (PGSIZE / DISK_SECTOR_SIZE) + 1];
+	size_t iov_cnt = 0;
+	disk_sector_t run_start = 0;
+	size_t run_cnt = 0;
+	off_t bytes_read = 0;
+	off_t length;
+	size_t i;
+
+	ASSERT (offset % DISK_SECTOR_SIZE == 0);
+
+	rwlock_acquire_read (&inode->rwlock);
+	length = inode_length (inode);
+	for (i = 0; i < cnt; i++) {
+		uint8_t *page = pages[i];
+		size_t ofs;
+
+		for (ofs = 0; ofs < PGSIZE; ofs += DISK_SECTOR_SIZE) {
+			off_t pos = offset + i * PGSIZE + ofs;
+			disk_sector_t sector;
+
+			if (pos >= length) {
+				memset (page + ofs, 0, PGSIZE - ofs);
+				break;
+			}
+			sector = byte_to_sector (inode, pos);
+
+			/* Start a new run unless this sector extends the current
+			 * one. */
+			if (run_cnt > 0 && (sector != run_start + run_cnt
+						|| run_cnt == DISK_XFER_MAX)) {
+				disk_readv (filesys_disk, run_start, iov, iov_cnt);
+				iov_cnt = run_cnt = 0;
+			}
+			if (run_cnt == 0)
+				run_start = sector;
+			if (iov_cnt > 0 && (uint8_t *) iov[iov_cnt - 1].buf
+					+ iov[iov_cnt - 1].sec_cnt * DISK_SECTOR_SIZE == page + ofs)
+				iov[iov_cnt - 1].sec_cnt++;
+			else
+				iov[iov_cnt++] = (struct disk_iov) { page + ofs, 1 };
+			run_cnt++;
+
+			if (pos + DISK_SECTOR_SIZE > length) {
+				/* The file ends inside this sector.  The disk fills the
+				 * whole sector; zero what lies beyond the end. */
+				disk_readv (filesys_disk, run_start, iov, iov_cnt);
+				iov_cnt = run_cnt = 0;
+				memset (page + ofs + (length - pos), 0,
+						PGSIZE - ofs - (length - pos));
+				bytes_read += length - pos;
+				break;
+			}
+			bytes_read += DISK_SECTOR_SIZE;
+		}
+	}
+	if (run_cnt > 0)
+		disk_readv (filesys_disk, run_start, iov, iov_cnt);
+	rwlock_release_read (&inode->rwlock);
+
+	return bytes_read;
+}
+
+/* Writes SIZE bytes into INODE, starting at OFFSET, which must be
+ * sector-aligned, from the page-sized buffers PAGES, filled in
+ * order.  Runs of consecutive sectors go to the disk as one request
+ * each, however the pages are laid out in memory.  Nothing is
+ * written past the end of the file.  Returns the number of bytes
+ * actually written. */
+off_t
+inode_write_pages (struct inode *inode, void **pages, off_t size,
+		off_t offset) {
+	struct disk_iov iov[DISK_XFER_MAX / (PGSIZE / DISK_SECTOR_SIZE) + 1];
+	size_t iov_cnt = 0;
+	disk_sector_t run_start = 0;
+	size_t run_cnt = 0;
+	uint8_t *bounce = NULL;
+	off_t bytes_written = 0;
+
+	ASSERT (offset % DISK_SECTOR_SIZE == 0);
+
+	rwlock_acquire_write (&inode->rwlock);
+	if (inode->deny_write_cnt) {
+		rwlock_release_write (&inode->rwlock);
+		return 0;
+	}
+	if (size > inode_length (inode) - offset)
+		size = inode_length (inode) - offset;
+
+	while (bytes_written < size) {
+		uint8_t *buf = (uint8_t *) pages[bytes_written / PGSIZE]
+			+ bytes_written % PGSIZE;
+		disk_sector_t sector = byte_to_sector (inode, offset + bytes_written);
+		off_t chunk_size = size - bytes_written;
+
+		if (chunk_size < DISK_SECTOR_SIZE) {
+			/* Last, partial sector: merge with what is on disk. */
+			if (run_cnt > 0) {
+				disk_writev (filesys_disk, run_start, iov, iov_cnt);
+				iov_cnt = run_cnt = 0;
+			}
+			bounce = malloc (DISK_SECTOR_SIZE);
+			if (bounce == NULL)
+				break;
+			disk_read (filesys_disk, sector, bounce);
+			memcpy (bounce, buf, chunk_size);
+			disk_write (filesys_disk, sector, bounce);
+			bytes_written += chunk_size;
+			break;
+		}
+
+		/* Start a new run unless this sector extends the current one. */
+		if (run_cnt > 0 && (sector != run_start + run_cnt
+					|| run_cnt == DISK_XFER_MAX)) {
+			disk_writev (filesys_disk, run_start, iov, iov_cnt);
+			iov_cnt = run_cnt = 0;
+		}
+		if (run_cnt == 0)
+			run_start = sector;
+		if (iov_cnt > 0 && (uint8_t *) iov[iov_cnt - 1].buf
+				+ iov[iov_cnt - 1].sec_cnt * DISK_SECTOR_SIZE == buf)
+			iov[iov_cnt - 1].sec_cnt++;
+		else
+			iov[iov_cnt++] = (struct disk_iov) { buf, 1 };
+		run_cnt++;
+		bytes_written += DISK_SECTOR_SIZE;
+	}
+	if (run_cnt > 0)
+		disk_writev (filesys_disk, run_start, iov, iov_cnt);
+	rwlock_release_write (&inode->rwlock);
+	free (bounce);
+
+	return bytes_written;
+}
+
 /* Writes SIZE bytes from BUFFER into INODE, starting at OFFSET.
  * Returns the number of bytes actually written, which may be
  * less than SIZE if end of file is reached or an error occurs.
  * (Normally a write at end of file would extend the inode, but
- * growth is not yet implemented.) */
+ * growth is not yet implemented.)
+ *
+ * A user BUFFER is copied in whole before INODE's rwlock is taken,
+ * as in inode_read_at(), so the write is applied in one piece. */
 off_t
 inode_write_at (struct inode *inode, const void *buffer_, off_t size,
 		off_t offset) {
 	const uint8_t *buffer = buffer_;
 	off_t bytes_written = 0;
-	uint8_t *bounce = NULL;
+	uint8_t *bounce;
+
+	if (size > 0 && is_user_vaddr (buffer)) {
+		uint8_t *copy = malloc (size);
+		if (copy == NULL)
+			return 0;
+		memcpy (copy, buffer, size);
+		bytes_written = inode_write_at (inode, copy, size, offset);
+		free (copy);
+		return bytes_written;
+	}
+
+	/* Allocated up front so that the loop below cannot stop short
+	   once the file has been extended. */
+	bounce = malloc (DISK_SECTOR_SIZE);
+	if (bounce == NULL)
+		return 0;
 
-	if (inode->deny_write_cnt)
+	rwlock_acquire_write (&inode->rwlock);
+	if (inode->deny_write_cnt) {
+		rwlock_release_write (&inode->rwlock);
+		free (bounce);
 		return 0;
+	}
 
 	if (inode_length(inode) < offset + size) {   // 생성된 파일의 inode length보다 쓰려는 offset과 size의 위치가 클 경우
 
@@ -350,13 +568,6 @@ inode_write_at (struct inode *inode, const void *buffer_, off_t size,
 			/* Write full sector directly to disk. */
 			disk_write (filesys_disk, sector_idx, buffer + bytes_written); 
 		} else {
-			/* We need a bounce buffer. */
-			if (bounce == NULL) {
-				bounce = malloc (DISK_SECTOR_SIZE);
-				if (bounce == NULL)
-					break;
-			}
-
 			/* If the sector contains data before or after the chunk
 			   we're writing, then we need to read in the sector
 			   first.  Otherwise we start with a sector of all zeros. */
@@ -373,6 +584,7 @@ inode_write_at (struct inode *inode, const void *buffer_, off_t size,
 		offset += chunk_size;
 		bytes_written += chunk_size;
 	}
+	rwlock_release_write (&inode->rwlock);
 	free (bounce);
 
 	return bytes_written;
@@ -383,8 +595,10 @@ inode_write_at (struct inode *inode, const void *buffer_, off_t size,
 	void
 inode_deny_write (struct inode *inode) 
 {
+	rwlock_acquire_write (&inode->rwlock);
 	inode->deny_write_cnt++;
 	ASSERT (inode->deny_write_cnt <= inode->open_cnt);
+	rwlock_release_write (&inode->rwlock);
 }
 
 /* Re-enables writes to INODE.
@@ -392,9 +606,11 @@ inode_deny_write (struct inode *inode)
  * inode_deny_write() on the inode, before closing the inode. */
 void
 inode_allow_write (struct inode *inode) {
+	rwlock_acquire_write (&inode->rwlock);
 	ASSERT (inode->deny_write_cnt > 0);
 	ASSERT (inode->deny_write_cnt <= inode->open_cnt);
 	inode->deny_write_cnt--;
+	rwlock_release_write (&inode->rwlock);
 }
 
 /* Returns the length, in bytes, of INODE's data. */
@@ -2,6 +2,7 @@
 #define DEVICES_DISK_H
 
 #include <inttypes.h>
+#include <stddef.h>
 #include <stdint.h>
 
 /* Size of a disk sector in bytes. */
@@ -15,6 +16,16 @@ typedef uint32_t disk_sector_t;
  * printf ("sector=%"PRDSNu"\n", sector); */
 #define PRDSNu PRIu32
 
+/* Most sectors one disk_readv() or disk_writev() can transfer. */
+#define DISK_XFER_MAX 256
+
+/* A run of SEC_CNT sectors' worth of memory at BUF, for
+ * disk_readv() and disk_writev(). */
+struct disk_iov {
+	void *buf;
+	size_t sec_cnt;
+};
+
 void disk_init (void);
 void disk_print_stats (void);
 
@@ -22,6 +33,10 @@ struct disk *disk_get (int chan_no, int dev_no);
 disk_sector_t disk_size (struct disk *);
 void disk_read (struct disk *, disk_sector_t, void *);
 void disk_write (struct disk *, disk_sector_t, const void *);
+void disk_readv (struct disk *, disk_sector_t,
+		const struct disk_iov *, size_t iov_cnt);
+void disk_writev (struct disk *, disk_sector_t,
+		const struct disk_iov *, size_t iov_cnt);
 
 void 	register_disk_inspect_intr ();
 #endif /* devices/disk.h */
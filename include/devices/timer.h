@@ -1,7 +1,9 @@
 #ifndef DEVICES_TIMER_H
 #define DEVICES_TIMER_H
 
+#include <list.h>
 #include <round.h>
+#include <stdbool.h>
 #include <stdint.h>
 
 /* Number of timer interrupts per second. */
@@ -12,6 +14,7 @@ void timer_calibrate (void);
 
 int64_t timer_ticks (void);
 int64_t timer_elapsed (int64_t);
+uint64_t timer_tsc_to_us (uint64_t cycles);
 
 void timer_sleep (int64_t ticks);
 void timer_msleep (int64_t milliseconds);
@@ -20,4 +23,23 @@ void timer_nsleep (int64_t nanoseconds);
 
 void timer_print_stats (void);
 
+void timer_idle_enter (void);
+void timer_idle_exit (void);
+
+/* Cancellable one-shot timeout, fired from the timer interrupt. */
+typedef void timeout_func (void *aux);
+
+struct timeout {
+	struct list_elem elem;      /* Element in a timing wheel slot. */
+	int64_t expires;            /* Tick at which to fire. */
+	timeout_func *func;         /* Function to call. */
+	void *aux;                  /* Argument to FUNC. */
+	bool armed;                 /* Waiting to fire? */
+};
+
+void timeout_init (struct timeout *, timeout_func *, void *aux);
+void timeout_arm (struct timeout *, int64_t expires);
+bool timeout_cancel (struct timeout *);
+bool timeout_pending (const struct timeout *);
+
 #endif /* devices/timer.h */
@@ -6,6 +6,7 @@
 #include "devices/disk.h"
 #include "filesys/fat.h"
 #include "lib/kernel/list.h"
+#include "threads/synch.h"
 
 struct bitmap;
 
@@ -17,7 +18,11 @@ disk_sector_t inode_get_inumber (const struct inode *);
 void inode_close (struct inode *);
 void inode_remove (struct inode *);
 off_t inode_read_at (struct inode *, void *, off_t size, off_t offset);
+off_t inode_read_pages (struct inode *, void **pages, size_t cnt,
+		off_t offset);
 off_t inode_write_at (struct inode *, const void *, off_t size, off_t offset);
+off_t inode_write_pages (struct inode *, void **pages, off_t size,
+		off_t offset);
 void inode_deny_write (struct inode *);
 void inode_allow_write (struct inode *);
 off_t inode_length (const struct inode *);
@@ -39,7 +44,13 @@ struct inode_disk {
 	char link_name[492];
 };
 
-/* In-memory inode. */
+/* In-memory inode.
+ *
+ * open_inodes_lock in inode.c guards elem and open_cnt.  RWLOCK
+ * guards the rest: inode_read_at() holds it shared, while
+ * inode_write_at() and anything that changes DATA or
+ * deny_write_cnt hold it exclusive.  DIR_LOCK serializes changes
+ * to the entries of a directory, see directory.c. */
 struct inode {
 	struct list_elem elem;              /* Element in inode list. */
 	disk_sector_t sector;               /* Sector number of disk location. */
@@ -47,6 +58,8 @@ struct inode {
 	bool removed;                       /* True if deleted, false otherwise. */
 	int deny_write_cnt;                 /* 0: writes ok, >0: deny writes. */
 	struct inode_disk data;             /* Inode content. */
+	struct rwlock rwlock;               /* Guards data and length. */
+	struct rwlock dir_lock;             /* Guards directory entries. */
 };
 
 #endif /* filesys/inode.h */
\ No newline at end of file
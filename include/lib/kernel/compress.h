@@ -0,0 +1,23 @@
+#ifndef __LIB_KERNEL_COMPRESS_H
+#define __LIB_KERNEL_COMPRESS_H
+
+/* Word-pattern compression.
+ *
+ * A small, fast compressor in the style of WKdm, meant for memory
+ * pages rather than files.  The input is treated as a sequence of
+ * 64-bit words, each of which is coded as zero, a repeat of the
+ * previous word, a hit in a 16-entry dictionary of recently seen
+ * words, or a literal.  Zero-filled and repetitive pages shrink to
+ * a few hundred bytes; random data does not compress at all.
+ *
+ * Compressed data records neither the original size nor any
+ * checksum, so the caller must keep both sizes. */
+
+#include <stddef.h>
+
+size_t compress_words (const void *src, size_t size, void *dst,
+		size_t dst_size);
+void decompress_words (const void *src, size_t src_size, void *dst,
+		size_t size);
+
+#endif /* lib/kernel/compress.h */
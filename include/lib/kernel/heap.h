@@ -0,0 +1,64 @@
+#ifndef __LIB_KERNEL_HEAP_H
+#define __LIB_KERNEL_HEAP_H
+
+/* Priority heap.
+ *
+ * This is an intrusive pairing heap.  Like lists and hash tables,
+ * it does not use dynamic allocation: each structure that can be
+ * in a heap embeds a struct heap_elem member, and heap_entry()
+ * converts a struct heap_elem back to the enclosing structure.
+ *
+ * heap_top() is the greatest element according to the heap's
+ * less function.  Elements that compare equal come out in the
+ * order they were pushed.  heap_push() is O(1); heap_pop(),
+ * heap_remove() and heap_update() are O(log n) amortized.
+ *
+ * The less function may look at data that changes while an
+ * element is in the heap, such as a thread's priority, but the
+ * owner must call heap_update() on the element after every such
+ * change, before the heap is used again. */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* Heap element. */
+struct heap_elem {
+	struct heap_elem *child;    /* First child. */
+	struct heap_elem *next;     /* Next sibling. */
+	struct heap_elem *prev;     /* Previous sibling, or parent if first. */
+	uint64_t seq;               /* Insertion order, breaks ties. */
+};
+
+/* Converts pointer to heap element HEAP_ELEM into a pointer to
+   the structure that HEAP_ELEM is embedded inside.  Supply the
+   name of the outer structure STRUCT and the member name MEMBER
+   of the heap element. */
+#define heap_entry(HEAP_ELEM, STRUCT, MEMBER)           \
+	((STRUCT *) ((uint8_t *) (HEAP_ELEM)            \
+		- offsetof (STRUCT, MEMBER)))
+
+/* Compares the value of two heap elements A and B, given
+   auxiliary data AUX.  Returns true if A is less than B, or
+   false if A is greater than or equal to B. */
+typedef bool heap_less_func (const struct heap_elem *a,
+		const struct heap_elem *b,
+		void *aux);
+
+/* Heap. */
+struct heap {
+	struct heap_elem *root;     /* Greatest element, or NULL. */
+	heap_less_func *less;       /* Comparison function. */
+	void *aux;                  /* Auxiliary data for `less'. */
+	uint64_t seq;               /* Next insertion sequence number. */
+};
+
+void heap_init (struct heap *, heap_less_func *, void *aux);
+bool heap_empty (const struct heap *);
+struct heap_elem *heap_top (const struct heap *);
+void heap_push (struct heap *, struct heap_elem *);
+struct heap_elem *heap_pop (struct heap *);
+void heap_remove (struct heap *, struct heap_elem *);
+void heap_update (struct heap *, struct heap_elem *);
+
+#endif /* lib/kernel/heap.h */
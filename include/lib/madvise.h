@@ -0,0 +1,18 @@
+#ifndef __LIB_MADVISE_H
+#define __LIB_MADVISE_H
+
+/* Advice for the SYS_MADVISE system call on how a range of
+   memory will be used. */
+#define MADV_NORMAL     0       /* No special treatment. */
+#define MADV_SEQUENTIAL 1       /* Read in order: read ahead a lot and
+                                   drop pages soon after use. */
+#define MADV_RANDOM     2       /* Read in no order: no readahead. */
+#define MADV_WILLNEED   3       /* Read the range in now. */
+#define MADV_DONTNEED   4       /* Drop the range now.  File pages are
+                                   written back; anonymous pages read
+                                   back as zeros, and pages of the
+                                   executable as they are in it. */
+#define MADV_FREE       5       /* Anonymous pages may be dropped instead
+                                   of swapped, unless written again. */
+
+#endif /* lib/madvise.h */
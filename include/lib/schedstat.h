@@ -0,0 +1,22 @@
+#ifndef __LIB_SCHEDSTAT_H
+#define __LIB_SCHEDSTAT_H
+
+#include <stdint.h>
+
+/* Number of buckets in a wakeup latency histogram.  Bucket 0
+   counts latencies under 1 us, bucket N (0 < N < last) counts
+   latencies in [2^(N-1), 2^N) us, and the last bucket counts
+   everything longer. */
+#define SCHED_LAT_BUCKETS 16
+
+/* Per-thread scheduler statistics, as returned by the
+   SYS_SCHED_STATS system call. */
+struct sched_stats {
+	uint64_t run_us;                /* Time spent running. */
+	uint64_t voluntary_switches;    /* Times it blocked or exited. */
+	uint64_t involuntary_switches;  /* Times it was preempted or yielded. */
+	uint64_t max_latency_us;        /* Longest wakeup-to-run latency. */
+	uint64_t latency[SCHED_LAT_BUCKETS]; /* Wakeup-to-run histogram. */
+};
+
+#endif /* lib/schedstat.h */
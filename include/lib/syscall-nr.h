@@ -36,6 +36,13 @@ enum {
 
 	SYS_MOUNT,
 	SYS_UMOUNT,
+
+	/* Diagnostics. */
+	SYS_SCHED_STATS,            /* Scheduler statistics of a thread. */
+
+	/* Memory hints. */
+	SYS_MADVISE,                /* Advise on the use of a range of memory. */
+	SYS_MSYNC,                  /* Write back a range of mapped memory. */
 };
 
 #endif /* lib/syscall-nr.h */
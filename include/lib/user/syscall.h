@@ -4,6 +4,8 @@
 #include <stdbool.h>
 #include <debug.h>
 #include <stddef.h>
+#include <schedstat.h>
+#include <madvise.h>
 
 /* Process identifier. */
 typedef int pid_t;
@@ -41,6 +43,8 @@ int dup2(int oldfd, int newfd);
 /* Project 3 and optionally project 4. */
 void *mmap (void *addr, size_t length, int writable, int fd, off_t offset);
 void munmap (void *addr);
+int madvise (void *addr, size_t length, int advice);
+int msync (void *addr, size_t length);
 
 /* Project 4 only. */
 bool chdir (const char *dir);
@@ -50,6 +54,9 @@ bool isdir (int fd);
 int inumber (int fd);
 int symlink (const char* target, const char* linkpath);
 
+/* Diagnostics. */
+bool get_sched_stats (pid_t, struct sched_stats *);
+
 static inline void* get_phys_addr (void *user_addr) {
 	void* pa;
 	asm volatile ("movq %0, %%rax" ::"r"(user_addr));
@@ -0,0 +1,34 @@
+#ifndef THREADS_LOCKSTAT_H
+#define THREADS_LOCKSTAT_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Lock contention profiler.
+ *
+ * When enabled with the -lockstat kernel option, lock_acquire()
+ * and sema_down() record statistics per call site, that is, per
+ * address they were called from.  lockstat_print() lists the most
+ * contended sites; feed the addresses to utils/backtrace to turn
+ * them into function names. */
+
+/* Statistics for one call site. */
+struct lockstat_site {
+	uintptr_t caller;           /* Address lock_acquire() etc. returns to. */
+	bool is_lock;               /* Lock, as opposed to a semaphore. */
+	uint64_t acquired;          /* # of acquisitions. */
+	uint64_t contended;         /* # of them that had to wait. */
+	uint64_t wait_tsc;          /* Total time spent waiting. */
+	uint64_t max_wait_tsc;      /* Longest wait. */
+	uint64_t max_hold_tsc;      /* Longest hold, locks only. */
+};
+
+/* -lockstat: Profile lock contention? */
+extern bool lockstat_enabled;
+
+struct lockstat_site *lockstat_record (uintptr_t caller, bool is_lock,
+		bool contended, uint64_t wait_tsc);
+void lockstat_record_hold (struct lockstat_site *, uint64_t hold_tsc);
+void lockstat_print (int top_n);
+
+#endif /* threads/lockstat.h */
@@ -1,13 +1,15 @@
 #ifndef THREADS_SYNCH_H
 #define THREADS_SYNCH_H
 
+#include <heap.h>
 #include <list.h>
 #include <stdbool.h>
+#include <stdint.h>
 
 /* A counting semaphore. */
 struct semaphore {
 	unsigned value;             /* 현재 세마포어 값 */
-	struct list waiters;        /* 대기 중인 스레드 목록 */
+	struct heap waiters;        /* 대기 중인 스레드, 우선순위 순 */
 };
 
 void sema_init (struct semaphore *, unsigned value);
@@ -15,10 +17,22 @@ void sema_down (struct semaphore *);
 bool sema_try_down (struct semaphore *);
 void sema_up (struct semaphore *);
 void sema_self_test (void);
+
+/* A hold on a lock or rwlock, as seen by priority donation.  It
+   sits in the holder's held_locks heap and raises the holder's
+   priority to that of the highest-priority thread in WAITERS. */
+struct lock_hold {
+	struct heap_elem elem;      /* Element in holder's held_locks. */
+	struct heap *waiters;       /* Threads waiting for the lock. */
+};
+
 /* Lock. */
 struct lock {
 	struct thread *holder;      /* Thread holding lock (for debugging). */
 	struct semaphore semaphore; /* Binary semaphore controlling access. */
+	struct lock_hold hold;      /* Holder's hold on the lock. */
+	struct lockstat_site *stat_site; /* Profiled call site, or NULL. */
+	uint64_t stat_tsc;          /* When it was taken, if profiled. */
 };
 
 void lock_init (struct lock *);
@@ -27,10 +41,44 @@ bool lock_try_acquire (struct lock *);
 void lock_release (struct lock *);
 bool lock_held_by_current_thread (const struct lock *);
 void refresh_priority(void);
+void held_locks_init (struct heap *);
+
+/* Readers-writer lock.  Any number of readers or a single
+   writer may hold it.  Once a writer waits, new readers wait
+   too, so a stream of readers cannot starve writers.  Waiters
+   donate their priority to the writer or to every reader. */
+struct rwlock {
+	struct thread *writer;      /* Thread holding it to write, or NULL. */
+	unsigned readers;           /* # of threads holding it to read. */
+	unsigned writers_waiting;   /* # of waiters that want to write. */
+	struct heap waiters;        /* Waiting threads, by priority. */
+	struct list read_holds;     /* Readers' struct rwlock_holds. */
+	struct lock_hold hold;      /* Writer's hold on the rwlock. */
+};
+
+/* A reader's hold on an rwlock.  Each thread has RWLOCK_HOLD_MAX
+   of them, which bounds the number of rwlocks it can hold to
+   read at once.  A reader may take the same rwlock again, so holds
+   are counted. */
+#define RWLOCK_HOLD_MAX 4
+struct rwlock_hold {
+	struct lock_hold hold;      /* Reader's hold, for donation. */
+	struct rwlock *rwlock;      /* Rwlock held, or NULL if unused. */
+	unsigned depth;             /* # of times it is held. */
+	struct thread *reader;      /* Thread holding it. */
+	struct list_elem elem;      /* Element in rwlock's read_holds. */
+};
+
+void rwlock_init (struct rwlock *);
+void rwlock_acquire_read (struct rwlock *);
+void rwlock_release_read (struct rwlock *);
+void rwlock_acquire_write (struct rwlock *);
+void rwlock_release_write (struct rwlock *);
+bool rwlock_held_by_current_thread (const struct rwlock *);
 
 /* Condition variable. */
 struct condition {
-	struct list waiters;        /* List of waiting threads. */
+	struct heap waiters;        /* Waiting threads, by priority. */
 };
 
 void cond_init (struct condition *);
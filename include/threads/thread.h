@@ -2,10 +2,13 @@
 #define THREADS_THREAD_H
 
 #include <debug.h>
+#include <heap.h>
 #include <list.h>
+#include <schedstat.h>
 #include <stdint.h>
 #include "threads/interrupt.h"
 #include "threads/synch.h"
+#include "threads/fixed-point.h"
 #ifdef VM
 #include "vm/vm.h"
 #endif
@@ -29,10 +32,15 @@ typedef int tid_t;
 #define PRI_DEFAULT 31                  /* Default priority. */
 #define PRI_MAX 63                      /* Highest priority. */
 
+/* Thread niceness for the 4.4BSD scheduler. */
+#define NICE_MIN -20                    /* Nicest. */
+#define NICE_DEFAULT 0                  /* Default niceness. */
+#define NICE_MAX 20                     /* Least nice. */
+
 
 // for system call
-#define FDT_PAGES 3   
-#define FDCOUNT_LIMIT FDT_PAGES *(1 << 9) 
+#define FDT_INLINE 8                    /* fdt entries kept in struct thread. */
+#define FDCOUNT_LIMIT (3 * (1 << 9))    /* Max fdt entries per process. */
 
 /* A kernel thread or user process.
  *
@@ -97,16 +105,35 @@ struct thread {
 	enum thread_status status;          /* Thread state. */
 	char name[16];                      /* Name (for debugging purposes). */
 	int priority;                       /* Priority. */
-	int64_t wake_time;
+	int64_t wake_time;                  /* Tick to wake up at, if sleeping. */
+	struct list_elem all_elem;          /* List element for all threads list. */
+
+	/* 4.4BSD scheduler (mlfqs). */
+	int nice;                           /* Niceness. */
+	fixed_t recent_cpu;                 /* Recent CPU time, decayed. */
+	int64_t recent_cpu_epoch;           /* Last second recent_cpu was decayed. */
+
+	/* Scheduler accounting, in time-stamp counter cycles. */
+	uint64_t run_tsc;                   /* Total time spent running. */
+	uint64_t sched_in_tsc;              /* When it last started running. */
+	uint64_t ready_tsc;                 /* When unblocked, 0 if not woken. */
+	uint64_t max_latency_tsc;           /* Longest wakeup-to-run latency. */
+	uint32_t voluntary_switches;        /* Blocked or exited. */
+	uint32_t involuntary_switches;      /* Preempted or yielded. */
+	uint32_t latency_hist[SCHED_LAT_BUCKETS]; /* Wakeup-to-run latencies. */
 
 	/* Shared between thread.c and synch.c. */
 	struct list_elem elem;              /* List element. */
+	struct heap_elem wait_elem;         /* Element in a waiter heap. */
+	struct heap *wait_heap;             /* Waiter heap it is in, or NULL. */
 
 	/* donation 추가 항목*/
 	int origin_priority;	// donation 받기 전 본인의 우선순위 저장
-	struct list donation_list; // 본인에게 기부해준 스레드들 저장 (donation 받은 것)
-	struct list_elem donation_elem;
+	struct heap held_locks; // 가지고 있는 lock들, 기부하는 우선순위 순
 	struct lock *waiting_lock; // donation해준 이유, 현재 스레드가 기다리고 있는 lock
+	struct rwlock *waiting_rwlock; // 기다리고 있는 rwlock
+	bool waiting_write;        // rwlock을 쓰기로 기다리는 중인지
+	struct rwlock_hold rw_holds[RWLOCK_HOLD_MAX]; // 읽기로 가지고 있는 rwlock들
 
 	/*project2 system call 추가*/
 	int exit_status; 
@@ -119,7 +146,9 @@ struct thread {
 	struct semaphore fork_sema;
 
 	int next_fd;
-	struct file **fdt;
+	struct file **fdt;                  /* fdt_inline or a malloc'd table. */
+	int fdt_size;                       /* # of entries in fdt. */
+	struct file *fdt_inline[FDT_INLINE];
 	struct file *running;
 
 	/*project3 growth stack*/
@@ -151,7 +180,9 @@ void thread_init (void);
 void thread_start (void);
 
 void thread_tick (void);
+void thread_idle_tick (void);
 void thread_print_stats (void);
+bool thread_get_sched_stats (tid_t, struct sched_stats *);
 
 typedef void thread_func (void *aux);
 tid_t thread_create (const char *name, int priority, thread_func *, void *);
@@ -165,6 +196,7 @@ const char *thread_name (void);
 
 void thread_exit (void) NO_RETURN;
 void thread_yield (void);
+void thread_requeue (struct thread *, int priority);
 
 int thread_get_priority (void);
 void thread_set_priority (int);
@@ -177,9 +209,5 @@ int thread_get_load_avg (void);
 void do_iret (struct intr_frame *tf);
 
 void thread_sleep(int64_t start, int64_t ticks);
-void thread_wake(int64_t ticks);
-
-void donate_priority(void);
-bool high_donation_priority(const struct list_elem *a, const struct list_elem *b,  void *aux UNUSED);
 
 #endif /* threads/thread.h */
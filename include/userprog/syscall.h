@@ -1,8 +1,6 @@
 #ifndef USERPROG_SYSCALL_H
 #define USERPROG_SYSCALL_H
 
-struct lock filesys_lock;
-
 void syscall_init (void);
 
 #endif /* userprog/syscall.h */
@@ -4,12 +4,28 @@
 struct page;
 enum vm_type;
 
+struct zswap_entry;
+struct lazy_load_info;
+
 struct anon_page {
     int swap_index;//swap된 데이터들이 저장된 섹터 구역
     //익명 페이지가 스왑 영역에 저장된 위치를 식별하는 데 사용
+    struct zswap_entry *zentry; /* In the compressed swap cache, or NULL. */
+    struct lazy_load_info *text; /* Read-only executable page to reload
+                                    from, or NULL. */
+    struct lazy_load_info *segment; /* Writable executable page to reload
+                                       from once discarded, or NULL. */
+    bool lazy_free;             /* MADV_FREE: drop instead of swapping
+                                   unless written since. */
 };
 
+/* Most pages swapped in or out with one disk request. */
+#define SWAP_CLUSTER_MAX 16
+
 void vm_anon_init (void);
 bool anon_initializer (struct page *page, enum vm_type type, void *kva);
+bool anon_swap_out_cluster (struct page **pages, size_t cnt);
+void anon_swap_in_cluster (struct page **pages, size_t cnt);
+void anon_discard (struct page *page);
 
 #endif
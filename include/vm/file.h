@@ -12,9 +12,23 @@ struct file_page {
 	off_t read_bytes;/** type 확실치 않음 */
 };
 
+/* Most pages written back in one batch. */
+#define FILE_WB_BATCH 64
+
+/* A dirty file-backed page queued for writeback.  The frame is
+ * pinned and the inode reopened until the write is done, so the
+ * page itself may go away meanwhile. */
+struct file_wb {
+	struct inode *inode;        /* File to write to. */
+	off_t ofs;                  /* Offset in the file. */
+	off_t len;                  /* Bytes to write, at most PGSIZE. */
+	struct frame *frame;        /* Frame holding the data. */
+};
+
 void vm_file_init (void);
 bool file_backed_initializer (struct page *page, enum vm_type type, void *kva);
 void *do_mmap(void *addr, size_t length, int writable,
 		struct file *file, off_t offset);
 void do_munmap (void *va);
+void file_backed_writeback (struct file_wb *wb, size_t cnt);
 #endif
@@ -47,10 +47,12 @@ struct page {
 	struct frame *frame;   /* Back reference for frame */
 
 	/* Your implementation 내가 추가 */
-	struct hash_elem hash_elem;
 	bool writable;
+	struct thread *owner;          /* Thread whose pml4 maps the page. */
+	struct list_elem share_elem;   /* Element in frame's pages list. */
+	bool drop_behind;              /* Evict without a second chance
+	                                  (MADV_SEQUENTIAL). */
 	uint32_t file_length;
-	off_t page_cnt;
 
 	/* Per-type data are binded into the union.
 	 * Each function automatically detects the current union */
@@ -63,12 +65,32 @@ struct page {
 #endif
 	};
 };
-/* The representation of "frame" */
+/* The representation of "frame".
+ * There is one frame per user pool page, kept in an array indexed by
+ * the page's position in the pool, so frames are never allocated or
+ * freed.  A frame with no pages is not in use.
+ *
+ * After fork a frame may be shared copy-on-write by several pages,
+ * each mapped read-only in its owner's pml4, until each writer gets a
+ * copy in vm_handle_wp(). */
 struct frame {
 	void *kva;
-	struct page *page;
-
-	struct list_elem frame_elem;
+	struct list pages;     /* Pages mapping this frame. */
+	size_t share_cnt;      /* Number of elements in PAGES. */
+	int pin_cnt;           /* Not to be evicted while nonzero. */
+	bool evicting;         /* Pages are being written out. */
+
+	/* Same-page merging. */
+	struct hash_elem ksm_elem;  /* Element in the merge table. */
+	uint64_t ksm_hash;          /* Contents hash when last scanned. */
+	bool ksm_listed;            /* In the merge table? */
+
+	/* Shared executable text. */
+	struct hash_elem text_elem; /* Element in the text table. */
+	struct inode *text_inode;   /* Executable the contents came from, */
+	off_t text_ofs;             /* ...at this offset, */
+	uint32_t text_len;          /* ...this many bytes, rest zero. */
+	bool text_listed;           /* In the text table? */
 };
 
 /* The function table for page operations.
@@ -87,12 +109,50 @@ struct page_operations {
 #define destroy(page) \
 	if ((page)->operations->destroy) (page)->operations->destroy (page)
 
+/* Lowest address the user stack may grow down to is
+ * USER_STACK - USER_STK_LIMIT, unless the executable asks for
+ * another size, up to USER_STK_MAX, in its PT_GNU_STACK header. */
+#define USER_STK_LIMIT (1 << 20)
+#define USER_STK_MAX (64 << 20)
+
+/* Pages added to the stack by each growth fault, by default. */
+#define STACK_GROW_PAGES 4
+
+extern size_t stack_grow_pages;
+
+/* A virtual memory area: a run of pages of one process that share
+ * their type, permissions and backing file.  The pages themselves
+ * are still created lazily, one struct page each; the area records
+ * what the range was mapped as. */
+struct vm_area {
+	void *start;                /* First page. */
+	void *end;                  /* One past the last page. */
+	enum vm_type type;          /* VM_ANON or VM_FILE. */
+	bool writable;
+	struct file *file;          /* Backing file, or NULL. */
+	off_t ofs;                  /* Offset in FILE of START. */
+	int advice;                 /* MADV_NORMAL, MADV_SEQUENTIAL or
+	                               MADV_RANDOM. */
+	struct list_elem elem;      /* Element in spt's areas list. */
+
+	/* Fault-around. */
+	void *ra_next;              /* Where a sequential fault lands next. */
+	size_t ra_window;           /* Pages read in by the last fault. */
+};
+
+struct spt_node;
+
 /* Representation of current process's memory space.
  * We don't want to force you to obey any specific design for this struct.
  * All designs up to you for this.
- * project3-1 구현 */
+ * project3-1 구현
+ *
+ * Pages live in a radix tree indexed by user page number, so a
+ * lookup is a fixed number of pointer chases and never allocates.
+ * Areas are kept in a list sorted by address. */
 struct supplemental_page_table {
-	struct hash pages;
+	struct spt_node *root;      /* Radix tree of pages, or NULL. */
+	struct list areas;          /* List of struct vm_area. */
 };
 
 #include "threads/thread.h"
@@ -104,6 +164,15 @@ struct page *spt_find_page (struct supplemental_page_table *spt,
 		void *va);
 bool spt_insert_page (struct supplemental_page_table *spt, struct page *page);
 void spt_remove_page (struct supplemental_page_table *spt, struct page *page);
+struct vm_area *spt_add_area (struct supplemental_page_table *spt,
+		void *start, void *end, enum vm_type type, bool writable,
+		struct file *file, off_t ofs);
+struct vm_area *spt_find_area (struct supplemental_page_table *spt,
+		const void *va);
+void spt_remove_area (struct supplemental_page_table *spt,
+		struct vm_area *area);
+void spt_remove_range (struct supplemental_page_table *spt, void *start,
+		void *end);
 
 void vm_init (void);
 bool vm_try_handle_fault (struct intr_frame *f, void *addr, bool user,
@@ -115,7 +184,13 @@ bool vm_alloc_page_with_initializer (enum vm_type type, void *upage,
 		bool writable, vm_initializer *init, void *aux);
 void vm_dealloc_page (struct page *page);
 bool vm_claim_page (void *va);
+void vm_free_frame (struct page *page);
+bool vm_madvise (void *addr, size_t length, int advice);
+void vm_writeback (struct supplemental_page_table *spt, void *start,
+		void *end);
+bool vm_msync (void *addr, size_t length);
 enum vm_type page_get_type (struct page *page);
+void vm_print_stats (void);
 
 
 
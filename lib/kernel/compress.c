@@ -0,0 +1,122 @@
+/* Word-pattern compression.
+
+   See compress.h for basic information.
+
+   The compressed form is a tag array, two bits per word and four
+   words per byte, followed by the payloads of the words in order:
+   nothing for TAG_ZERO and TAG_REPEAT, a one-byte dictionary index
+   for TAG_DICT, and the eight-byte word for TAG_LITERAL.  The
+   decompressor rebuilds the dictionary exactly as the compressor
+   built it, so the dictionary itself is never stored. */
+
+#include "compress.h"
+#include <stdint.h>
+#include <string.h>
+#include "../debug.h"
+
+/* Word tags. */
+enum {
+	TAG_ZERO,       /* Word is 0. */
+	TAG_REPEAT,     /* Same as the previous word. */
+	TAG_DICT,       /* Found in the dictionary. */
+	TAG_LITERAL     /* Stored as is. */
+};
+
+#define DICT_SIZE 16
+
+/* Returns the dictionary slot for WORD. */
+static inline unsigned
+dict_slot (uint64_t word) {
+	return (word * 0x9e3779b97f4a7c15ULL) >> 60;
+}
+
+/* Compresses the SIZE bytes at SRC, which must be a multiple of 8,
+   into the DST_SIZE bytes at DST.  Returns the compressed size, or
+   0 if it would not fit in DST_SIZE bytes. */
+size_t
+compress_words (const void *src, size_t size, void *dst, size_t dst_size) {
+	const uint64_t *in = src;
+	size_t word_cnt = size / sizeof (uint64_t);
+	size_t tag_bytes = (word_cnt + 3) / 4;
+	uint8_t *tags = dst;
+	uint8_t *out = tags + tag_bytes;
+	uint8_t *end = (uint8_t *) dst + dst_size;
+	uint64_t dict[DICT_SIZE] = { 0 };
+	uint64_t prev = 0;
+	size_t i;
+
+	ASSERT (size % sizeof (uint64_t) == 0);
+
+	if (tag_bytes > dst_size)
+		return 0;
+	memset (tags, 0, tag_bytes);
+
+	for (i = 0; i < word_cnt; i++) {
+		uint64_t word;
+		unsigned tag, slot;
+
+		memcpy (&word, &in[i], sizeof word);
+		slot = dict_slot (word);
+		if (word == 0)
+			tag = TAG_ZERO;
+		else if (word == prev)
+			tag = TAG_REPEAT;
+		else if (dict[slot] == word) {
+			if (out + 1 > end)
+				return 0;
+			*out++ = slot;
+			tag = TAG_DICT;
+		} else {
+			if (out + sizeof word > end)
+				return 0;
+			memcpy (out, &word, sizeof word);
+			out += sizeof word;
+			dict[slot] = word;
+			tag = TAG_LITERAL;
+		}
+		tags[i / 4] |= tag << (i % 4 * 2);
+		prev = word;
+	}
+	return out - (uint8_t *) dst;
+}
+
+/* Decompresses the SRC_SIZE bytes at SRC, produced by
+   compress_words() from SIZE bytes, into the SIZE bytes at DST. */
+void
+decompress_words (const void *src, size_t src_size, void *dst, size_t size) {
+	uint64_t *outw = dst;
+	size_t word_cnt = size / sizeof (uint64_t);
+	const uint8_t *tags = src;
+	const uint8_t *in = tags + (word_cnt + 3) / 4;
+	const uint8_t *end = (const uint8_t *) src + src_size;
+	uint64_t dict[DICT_SIZE] = { 0 };
+	uint64_t prev = 0;
+	size_t i;
+
+	ASSERT (size % sizeof (uint64_t) == 0);
+
+	for (i = 0; i < word_cnt; i++) {
+		uint64_t word;
+
+		switch ((tags[i / 4] >> (i % 4 * 2)) & 3) {
+			case TAG_ZERO:
+				word = 0;
+				break;
+			case TAG_REPEAT:
+				word = prev;
+				break;
+			case TAG_DICT:
+				ASSERT (in < end);
+				word = dict[*in++ % DICT_SIZE];
+				break;
+			default:
+				ASSERT (in + sizeof word <= end);
+				memcpy (&word, in, sizeof word);
+				in += sizeof word;
+				dict[dict_slot (word)] = word;
+				break;
+		}
+		memcpy (&outw[i], &word, sizeof word);
+		prev = word;
+	}
+}
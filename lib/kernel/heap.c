@@ -0,0 +1,170 @@
+/* Priority heap.
+
+   See heap.h for basic information.
+
+   The heap is a pairing heap: a multiway tree in which every node
+   is at least as great as its children, kept as first-child /
+   next-sibling links.  Pushing melds a one-node tree with the
+   root; popping melds the root's children pairwise from left to
+   right and then folds the results from right to left. */
+
+#include "heap.h"
+#include "../debug.h"
+
+static bool above (const struct heap *, const struct heap_elem *,
+		const struct heap_elem *);
+static struct heap_elem *meld (struct heap *, struct heap_elem *,
+		struct heap_elem *);
+static struct heap_elem *merge_pairs (struct heap *, struct heap_elem *);
+
+/* Initializes heap H to order its elements using LESS, given
+   auxiliary data AUX. */
+void
+heap_init (struct heap *h, heap_less_func *less, void *aux) {
+	ASSERT (h != NULL);
+	ASSERT (less != NULL);
+
+	h->root = NULL;
+	h->less = less;
+	h->aux = aux;
+	h->seq = 0;
+}
+
+/* Returns true if H contains no elements. */
+bool
+heap_empty (const struct heap *h) {
+	return h->root == NULL;
+}
+
+/* Returns the greatest element in H, which must not be empty. */
+struct heap_elem *
+heap_top (const struct heap *h) {
+	ASSERT (!heap_empty (h));
+	return h->root;
+}
+
+/* Inserts E into H. */
+void
+heap_push (struct heap *h, struct heap_elem *e) {
+	ASSERT (e != NULL);
+
+	e->child = e->next = e->prev = NULL;
+	e->seq = h->seq++;
+	h->root = meld (h, h->root, e);
+}
+
+/* Removes and returns the greatest element in H, which must not
+   be empty. */
+struct heap_elem *
+heap_pop (struct heap *h) {
+	struct heap_elem *top = heap_top (h);
+
+	h->root = merge_pairs (h, top->child);
+	top->child = NULL;
+	return top;
+}
+
+/* Removes E, which must be in H, from H. */
+void
+heap_remove (struct heap *h, struct heap_elem *e) {
+	struct heap_elem *sub;
+
+	if (e == h->root) {
+		heap_pop (h);
+		return;
+	}
+
+	/* Cut E's subtree out of its parent's child list. */
+	ASSERT (e->prev != NULL);
+	if (e->prev->child == e)
+		e->prev->child = e->next;
+	else
+		e->prev->next = e->next;
+	if (e->next != NULL)
+		e->next->prev = e->prev;
+	e->next = e->prev = NULL;
+
+	sub = merge_pairs (h, e->child);
+	e->child = NULL;
+	h->root = meld (h, h->root, sub);
+}
+
+/* Restores H's ordering after the value of E, which must be in H,
+   has changed.  E keeps its place among equal elements. */
+void
+heap_update (struct heap *h, struct heap_elem *e) {
+	heap_remove (h, e);
+	h->root = meld (h, h->root, e);
+}
+
+/* Returns true if A belongs above B: A is greater, or they are
+   equal and A was pushed first. */
+static bool
+above (const struct heap *h, const struct heap_elem *a,
+		const struct heap_elem *b) {
+	if (h->less (b, a, h->aux))
+		return true;
+	if (h->less (a, b, h->aux))
+		return false;
+	return a->seq < b->seq;
+}
+
+/* Melds the trees rooted at A and B, either of which may be
+   NULL, and returns the new root.  A and B must have no
+   siblings. */
+static struct heap_elem *
+meld (struct heap *h, struct heap_elem *a, struct heap_elem *b) {
+	struct heap_elem *t;
+
+	if (a == NULL)
+		return b;
+	if (b == NULL)
+		return a;
+	if (!above (h, a, b)) {
+		t = a;
+		a = b;
+		b = t;
+	}
+
+	/* B becomes A's first child. */
+	b->prev = a;
+	b->next = a->child;
+	if (a->child != NULL)
+		a->child->prev = b;
+	a->child = b;
+	return a;
+}
+
+/* Melds the sibling list starting at FIRST into a single tree
+   and returns its root, or NULL if FIRST is NULL. */
+static struct heap_elem *
+merge_pairs (struct heap *h, struct heap_elem *first) {
+	struct heap_elem *pairs = NULL;
+	struct heap_elem *root = NULL;
+
+	/* Left to right, meld adjacent pairs, stacking the results
+	   on PAIRS through their next pointers. */
+	while (first != NULL) {
+		struct heap_elem *a = first;
+		struct heap_elem *b = a->next;
+		struct heap_elem *m;
+
+		first = b != NULL ? b->next : NULL;
+		a->next = a->prev = NULL;
+		if (b != NULL)
+			b->next = b->prev = NULL;
+		m = meld (h, a, b);
+		m->next = pairs;
+		pairs = m;
+	}
+
+	/* Right to left, fold the pairs into one tree. */
+	while (pairs != NULL) {
+		struct heap_elem *next = pairs->next;
+
+		pairs->next = NULL;
+		root = meld (h, root, pairs);
+		pairs = next;
+	}
+	return root;
+}
@@ -0,0 +1,93 @@
+/* The main thread holds an rwlock to write while a writer and
+   two readers, all of higher priority, block acquiring it.  When
+   the main thread releases it, both readers are granted it in one
+   batch, ahead of the waiting writer.  The readers then block on
+   semaphores, still holding the rwlock, and a writer of even
+   higher priority blocks acquiring it.  Its donation must reach
+   both readers of the batch, not just the last one granted. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+
+struct rwlock_test
+  {
+    struct rwlock rwlock;
+    struct semaphore go[2];
+  };
+
+struct reader
+  {
+    struct rwlock_test *test;
+    int id;
+  };
+
+static thread_func reader_thread_func;
+static thread_func writer_thread_func;
+
+void
+test_priority_donate_rwlock_batch (void) 
+{
+  struct rwlock_test t;
+  struct reader r[2];
+  int i;
+
+  /* This test does not work with the MLFQS. */
+  ASSERT (!thread_mlfqs);
+
+  /* Make sure our priority is the default. */
+  ASSERT (thread_get_priority () == PRI_DEFAULT);
+
+  rwlock_init (&t.rwlock);
+  rwlock_acquire_write (&t.rwlock);
+  thread_create ("writer0", PRI_DEFAULT + 1, writer_thread_func, &t);
+  for (i = 0; i < 2; i++) 
+    {
+      char name[16];
+
+      sema_init (&t.go[i], 0);
+      r[i].test = &t;
+      r[i].id = i + 1;
+      snprintf (name, sizeof name, "reader%d", i + 1);
+      thread_create (name, PRI_DEFAULT + 2 + i, reader_thread_func, &r[i]);
+    }
+  msg ("This thread should have priority %d.  Actual priority: %d.",
+       PRI_DEFAULT + 3, thread_get_priority ());
+  rwlock_release_write (&t.rwlock);
+  msg ("This thread should have priority %d.  Actual priority: %d.",
+       PRI_DEFAULT, thread_get_priority ());
+
+  thread_create ("writer1", PRI_DEFAULT + 10, writer_thread_func, &t);
+  for (i = 0; i < 2; i++)
+    sema_up (&t.go[i]);
+  msg ("reader1, reader2, writer1, writer0 must already have finished.");
+  msg ("This should be the last line before finishing this test.");
+}
+
+static void
+reader_thread_func (void *r_) 
+{
+  struct reader *r = r_;
+  struct rwlock_test *t = r->test;
+
+  rwlock_acquire_read (&t->rwlock);
+  msg ("reader%d: got the rwlock", r->id);
+  sema_down (&t->go[r->id - 1]);
+  msg ("reader%d: should have priority %d.  Actual priority: %d.",
+       r->id, PRI_DEFAULT + 10, thread_get_priority ());
+  rwlock_release_read (&t->rwlock);
+  msg ("reader%d: done", r->id);
+}
+
+static void
+writer_thread_func (void *t_) 
+{
+  struct rwlock_test *t = t_;
+
+  rwlock_acquire_write (&t->rwlock);
+  msg ("%s: got the rwlock", thread_name ());
+  rwlock_release_write (&t->rwlock);
+  msg ("%s: done", thread_name ());
+}
@@ -0,0 +1,23 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(priority-donate-rwlock-batch) begin
+(priority-donate-rwlock-batch) This thread should have priority 34.  Actual priority: 34.
+(priority-donate-rwlock-batch) reader2: got the rwlock
+(priority-donate-rwlock-batch) reader1: got the rwlock
+(priority-donate-rwlock-batch) This thread should have priority 31.  Actual priority: 31.
+(priority-donate-rwlock-batch) reader1: should have priority 41.  Actual priority: 41.
+(priority-donate-rwlock-batch) reader1: done
+(priority-donate-rwlock-batch) reader2: should have priority 41.  Actual priority: 41.
+(priority-donate-rwlock-batch) writer1: got the rwlock
+(priority-donate-rwlock-batch) writer1: done
+(priority-donate-rwlock-batch) reader2: done
+(priority-donate-rwlock-batch) writer0: got the rwlock
+(priority-donate-rwlock-batch) writer0: done
+(priority-donate-rwlock-batch) reader1, reader2, writer1, writer0 must already have finished.
+(priority-donate-rwlock-batch) This should be the last line before finishing this test.
+(priority-donate-rwlock-batch) end
+EOF
+pass;
@@ -0,0 +1,71 @@
+/* The main thread and a reader both hold an rwlock to read, the
+   reader sleeping on a semaphore.  A high-priority writer then
+   blocks acquiring the rwlock, donating its priority to both
+   readers.  When the main thread drops its hold, only its own
+   donation goes away; the reader, woken up, must still run with
+   the writer's priority, and hand the rwlock over to it. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+
+struct rwlock_test
+  {
+    struct rwlock rwlock;
+    struct semaphore go;
+  };
+
+static thread_func reader_thread_func;
+static thread_func writer_thread_func;
+
+void
+test_priority_donate_rwlock (void) 
+{
+  struct rwlock_test t;
+
+  /* This test does not work with the MLFQS. */
+  ASSERT (!thread_mlfqs);
+
+  /* Make sure our priority is the default. */
+  ASSERT (thread_get_priority () == PRI_DEFAULT);
+
+  rwlock_init (&t.rwlock);
+  sema_init (&t.go, 0);
+  rwlock_acquire_read (&t.rwlock);
+  thread_create ("reader", PRI_DEFAULT + 1, reader_thread_func, &t);
+  thread_create ("writer", PRI_DEFAULT + 5, writer_thread_func, &t);
+  msg ("This thread should have priority %d.  Actual priority: %d.",
+       PRI_DEFAULT + 5, thread_get_priority ());
+  rwlock_release_read (&t.rwlock);
+  msg ("This thread should have priority %d.  Actual priority: %d.",
+       PRI_DEFAULT, thread_get_priority ());
+  sema_up (&t.go);
+  msg ("writer, reader must already have finished, in that order.");
+  msg ("This should be the last line before finishing this test.");
+}
+
+static void
+reader_thread_func (void *t_) 
+{
+  struct rwlock_test *t = t_;
+
+  rwlock_acquire_read (&t->rwlock);
+  sema_down (&t->go);
+  msg ("reader: should have priority %d.  Actual priority: %d.",
+       PRI_DEFAULT + 5, thread_get_priority ());
+  rwlock_release_read (&t->rwlock);
+  msg ("reader: done");
+}
+
+static void
+writer_thread_func (void *t_) 
+{
+  struct rwlock_test *t = t_;
+
+  rwlock_acquire_write (&t->rwlock);
+  msg ("writer: got the rwlock");
+  rwlock_release_write (&t->rwlock);
+  msg ("writer: done");
+}
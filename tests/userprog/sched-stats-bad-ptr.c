@@ -0,0 +1,13 @@
+/* Passes a null stats buffer to the sched_stats system call,
+   which must cause the process to be terminated with exit code
+   -1. */
+
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+void
+test_main (void) 
+{
+  msg ("get_sched_stats(NULL): %d", get_sched_stats (0, NULL));
+}
@@ -0,0 +1,26 @@
+/* Reads the scheduler statistics of the running process and
+   checks that they are consistent, then asks for those of a pid
+   that does not exist, which must fail. */
+
+#include <schedstat.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+void
+test_main (void) 
+{
+  struct sched_stats st;
+  uint64_t total = 0;
+  int i;
+
+  CHECK (get_sched_stats (0, &st), "get_sched_stats (0)");
+  for (i = 0; i < SCHED_LAT_BUCKETS; i++)
+    total += st.latency[i];
+  if (st.max_latency_us != 0 && total == 0)
+    fail ("max latency %llu us but empty histogram",
+          (unsigned long long) st.max_latency_us);
+
+  CHECK (!get_sched_stats ((pid_t) 0x0c020301, &st),
+         "get_sched_stats (bad pid) must fail");
+}
@@ -0,0 +1,12 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(sched-stats) begin
+(sched-stats) get_sched_stats (0)
+(sched-stats) get_sched_stats (bad pid) must fail
+(sched-stats) end
+sched-stats: exit(0)
+EOF
+pass;
@@ -0,0 +1,65 @@
+/* Forks while the parent has data in memory, so that parent and
+   child share those pages copy-on-write.  Both then write their
+   own pattern over them and check that each still sees its own,
+   also after pushing the pages out to swap. */
+
+#include <string.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define PAGE_SIZE 4096
+#define ONE_MB (1 << 20)
+#define SHARED_SIZE (8 * PAGE_SIZE)
+#define PRESSURE_SIZE (12 * ONE_MB)
+
+static char shared[SHARED_SIZE];
+static char pressure[PRESSURE_SIZE];
+
+/* Writes a byte to every page of PRESSURE, which does not fit in
+   memory, so that older pages get swapped out. */
+static void
+push_out (void)
+{
+  size_t i;
+
+  for (i = 0; i < PRESSURE_SIZE; i += PAGE_SIZE)
+    pressure[i] = (char) i;
+}
+
+static void
+check_shared (char expected, const char *what)
+{
+  size_t i;
+
+  msg ("%s", what);
+  for (i = 0; i < SHARED_SIZE; i++)
+    if (shared[i] != expected)
+      fail ("byte %zu is '%c', not '%c'", i, shared[i], expected);
+}
+
+void
+test_main (void)
+{
+  pid_t child;
+
+  memset (shared, 'P', SHARED_SIZE);
+  child = fork ("child");
+  if (child == 0)
+    {
+      check_shared ('P', "child: check inherited data");
+      memset (shared, 'c', SHARED_SIZE);
+      check_shared ('c', "child: check own data");
+      push_out ();
+      check_shared ('c', "child: check own data after swapping");
+      exit (0);
+    }
+
+  /* No output until the child is done, to keep the order fixed. */
+  memset (shared, 'p', SHARED_SIZE);
+  if (wait (child) != 0)
+    fail ("child failed");
+  check_shared ('p', "parent: check own data");
+  push_out ();
+  check_shared ('p', "parent: check own data after swapping");
+}
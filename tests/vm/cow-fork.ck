@@ -0,0 +1,14 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(cow-fork) begin
+(cow-fork) child: check inherited data
+(cow-fork) child: check own data
+(cow-fork) child: check own data after swapping
+(cow-fork) parent: check own data
+(cow-fork) parent: check own data after swapping
+(cow-fork) end
+EOF
+pass;
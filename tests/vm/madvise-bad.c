@@ -0,0 +1,26 @@
+/* Verifies that madvise rejects a misaligned address, unmapped
+   and kernel addresses, and an unknown advice value. */
+
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define PAGE_SIZE 4096
+
+static char buf[PAGE_SIZE * 2];
+
+void
+test_main (void)
+{
+  char *page = (char *) (((uintptr_t) buf + PAGE_SIZE - 1)
+                         & ~(uintptr_t) (PAGE_SIZE - 1));
+
+  CHECK (madvise (page + 1, PAGE_SIZE, MADV_DONTNEED) == -1,
+         "try to madvise misaligned address");
+  CHECK (madvise ((void *) 0x10000000, PAGE_SIZE, MADV_DONTNEED) == -1,
+         "try to madvise unmapped address");
+  CHECK (madvise ((void *) 0x8004000000, PAGE_SIZE, MADV_DONTNEED) == -1,
+         "try to madvise kernel address");
+  CHECK (madvise (page, PAGE_SIZE, 99) == -1,
+         "try to madvise with bad advice");
+}
@@ -0,0 +1,14 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(madvise-bad) begin
+(madvise-bad) try to madvise misaligned address
+(madvise-bad) try to madvise unmapped address
+(madvise-bad) try to madvise kernel address
+(madvise-bad) try to madvise with bad advice
+(madvise-bad) end
+madvise-bad: exit(0)
+EOF
+pass;
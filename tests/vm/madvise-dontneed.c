@@ -0,0 +1,51 @@
+/* Fills two anonymous pages, drops the first with MADV_DONTNEED,
+   and checks that it reads back as zeros while the second keeps
+   its contents.  Then does the same to a page of initialized
+   data, which must read back as it is in the executable. */
+
+#include <string.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define PAGE_SIZE 4096
+
+static char bss[PAGE_SIZE * 3];
+static char data[PAGE_SIZE * 2] = { [0 ... PAGE_SIZE * 2 - 1] = 'D' };
+
+static char *
+page_in (char *buf)
+{
+  return (char *) (((uintptr_t) buf + PAGE_SIZE - 1)
+                   & ~(uintptr_t) (PAGE_SIZE - 1));
+}
+
+static void
+check_page (const char *page, char expected, const char *name)
+{
+  size_t i;
+
+  msg ("check %s", name);
+  for (i = 0; i < PAGE_SIZE; i++)
+    if (page[i] != expected)
+      fail ("byte %zu of %s is %02hhx, not %02hhx",
+            i, name, page[i], expected);
+}
+
+void
+test_main (void)
+{
+  char *page = page_in (bss);
+
+  memset (page, 0xa5, PAGE_SIZE * 2);
+  CHECK (madvise (page, PAGE_SIZE, MADV_DONTNEED) == 0,
+         "madvise (MADV_DONTNEED) on bss");
+  check_page (page, 0, "dropped bss page");
+  check_page (page + PAGE_SIZE, (char) 0xa5, "kept bss page");
+
+  page = page_in (data);
+  memset (page, 0xa5, PAGE_SIZE);
+  CHECK (madvise (page, PAGE_SIZE, MADV_DONTNEED) == 0,
+         "madvise (MADV_DONTNEED) on data");
+  check_page (page, 'D', "dropped data page");
+}
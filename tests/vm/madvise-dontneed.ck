@@ -0,0 +1,14 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(madvise-dontneed) begin
+(madvise-dontneed) madvise (MADV_DONTNEED) on bss
+(madvise-dontneed) check dropped bss page
+(madvise-dontneed) check kept bss page
+(madvise-dontneed) madvise (MADV_DONTNEED) on data
+(madvise-dontneed) check dropped data page
+(madvise-dontneed) end
+EOF
+pass;
@@ -0,0 +1,26 @@
+/* Verifies that msync rejects a misaligned address and unmapped
+   and kernel addresses. */
+
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define ACTUAL ((void *) 0x10000000)
+
+void
+test_main (void)
+{
+  int handle;
+  void *map;
+
+  CHECK ((handle = open ("sample.txt")) > 1, "open \"sample.txt\"");
+  CHECK ((map = mmap (ACTUAL, 4096, 1, handle, 0)) != MAP_FAILED,
+         "mmap \"sample.txt\"");
+  CHECK (msync ((char *) map + 1, 4096) == -1,
+         "try to msync misaligned address");
+  CHECK (msync ((char *) map + 0x100000, 4096) == -1,
+         "try to msync unmapped address");
+  CHECK (msync ((void *) 0x8004000000, 4096) == -1,
+         "try to msync kernel address");
+  munmap (map);
+}
@@ -0,0 +1,15 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(msync-bad) begin
+(msync-bad) open "sample.txt"
+(msync-bad) mmap "sample.txt"
+(msync-bad) try to msync misaligned address
+(msync-bad) try to msync unmapped address
+(msync-bad) try to msync kernel address
+(msync-bad) end
+msync-bad: exit(0)
+EOF
+pass;
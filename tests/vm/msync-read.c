@@ -0,0 +1,34 @@
+/* Writes to a file through a mapping, calls msync, and checks
+   that read() on another descriptor sees the new contents while
+   the mapping is still in place. */
+
+#include <string.h>
+#include <syscall.h>
+#include "tests/vm/sample.inc"
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define ACTUAL ((void *) 0x10000000)
+
+void
+test_main (void)
+{
+  int map_handle, read_handle;
+  void *map;
+  char buf[1024];
+
+  CHECK (create ("sample.txt", strlen (sample)), "create \"sample.txt\"");
+  CHECK ((map_handle = open ("sample.txt")) > 1, "open \"sample.txt\"");
+  CHECK ((map = mmap (ACTUAL, 4096, 1, map_handle, 0)) != MAP_FAILED,
+         "mmap \"sample.txt\"");
+  memcpy (ACTUAL, sample, strlen (sample));
+  CHECK (msync (map, 4096) == 0, "msync \"sample.txt\"");
+
+  CHECK ((read_handle = open ("sample.txt")) > 1, "open \"sample.txt\" again");
+  CHECK (read (read_handle, buf, strlen (sample)) == (int) strlen (sample),
+         "read \"sample.txt\"");
+  CHECK (!memcmp (buf, sample, strlen (sample)),
+         "compare read data against written data");
+  close (read_handle);
+  munmap (map);
+}
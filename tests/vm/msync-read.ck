@@ -0,0 +1,16 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(msync-read) begin
+(msync-read) create "sample.txt"
+(msync-read) open "sample.txt"
+(msync-read) mmap "sample.txt"
+(msync-read) msync "sample.txt"
+(msync-read) open "sample.txt" again
+(msync-read) read "sample.txt"
+(msync-read) compare read data against written data
+(msync-read) end
+EOF
+pass;
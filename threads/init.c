@@ -16,6 +16,7 @@
 #include "threads/interrupt.h"
 #include "threads/io.h"
 #include "threads/loader.h"
+#include "threads/lockstat.h"
 #include "threads/malloc.h"
 #include "threads/mmu.h"
 #include "threads/palloc.h"
@@ -49,6 +50,9 @@ static bool format_filesys;
 /* -q: Power off after kernel tasks complete? */
 bool power_off_when_done;
 
+/* -lockstat: Number of lock call sites to print at shutdown. */
+static int lockstat_top = 10;
+
 bool thread_tests;
 
 static void bss_init (void);
@@ -221,11 +225,20 @@ parse_options (char **argv) {
 			random_init (atoi (value));
 		else if (!strcmp (name, "-mlfqs"))
 			thread_mlfqs = true;
+		else if (!strcmp (name, "-lockstat")) {
+			lockstat_enabled = true;
+			if (value != NULL)
+				lockstat_top = atoi (value);
+		}
 #ifdef USERPROG
 		else if (!strcmp (name, "-ul"))
 			user_page_limit = atoi (value);
 		else if (!strcmp (name, "-threads-tests"))
 			thread_tests = true;
+#endif
+#ifdef VM
+		else if (!strcmp (name, "-sg"))
+			stack_grow_pages = atoi (value) > 0 ? atoi (value) : 1;
 #endif
 		else
 			PANIC ("unknown option `%s' (use -h for help)", name);
@@ -326,8 +339,12 @@ usage (void) {
 			"  -f                 Format file system disk during startup.\n"
 			"  -rs=SEED           Set random number seed to SEED.\n"
 			"  -mlfqs             Use multi-level feedback queue scheduler.\n"
+			"  -lockstat[=N]      Profile locks, print top N (10) at shutdown.\n"
 #ifdef USERPROG
 			"  -ul=COUNT          Limit user memory to COUNT pages.\n"
+#endif
+#ifdef VM
+			"  -sg=COUNT          Grow user stacks COUNT pages at a time.\n"
 #endif
 			);
 	power_off ();
@@ -354,6 +371,7 @@ static void
 print_stats (void) {
 	timer_print_stats ();
 	thread_print_stats ();
+	lockstat_print (lockstat_top);
 #ifdef FILESYS
 	disk_print_stats ();
 #endif
@@ -362,4 +380,7 @@ print_stats (void) {
 #ifdef USERPROG
 	exception_print_stats ();
 #endif
+#ifdef VM
+	vm_print_stats ();
+#endif
 }
@@ -0,0 +1,115 @@
+#include "threads/lockstat.h"
+#include <debug.h>
+#include <stdio.h>
+#include "threads/interrupt.h"
+#include "devices/timer.h"
+
+/* Call sites are kept in an open-addressed hash table keyed by
+   caller address.  It is fixed-size so that recording never
+   allocates; acquisitions from sites that do not fit are only
+   counted. */
+#define LOCKSTAT_SITES 256      /* Power of 2. */
+static struct lockstat_site sites[LOCKSTAT_SITES];
+static uint64_t dropped;        /* Acquisitions from sites that did not fit. */
+
+bool lockstat_enabled;
+
+/* Returns the entry for CALLER, creating it if needed, or NULL
+   if the table is full. */
+static struct lockstat_site *
+find_site (uintptr_t caller) {
+	size_t i = (caller ^ (caller >> 12)) & (LOCKSTAT_SITES - 1);
+	size_t probes;
+
+	for (probes = 0; probes < LOCKSTAT_SITES; probes++) {
+		struct lockstat_site *s = &sites[i];
+
+		if (s->caller == caller)
+			return s;
+		if (s->caller == 0) {
+			s->caller = caller;
+			return s;
+		}
+		i = (i + 1) & (LOCKSTAT_SITES - 1);
+	}
+	return NULL;
+}
+
+/* Records an acquisition from CALLER that waited WAIT_TSC cycles,
+   CONTENDED telling whether it had to sleep.  Returns the site's
+   entry, for lockstat_record_hold(), or NULL. */
+struct lockstat_site *
+lockstat_record (uintptr_t caller, bool is_lock, bool contended,
+		uint64_t wait_tsc) {
+	struct lockstat_site *s;
+	enum intr_level old_level;
+
+	old_level = intr_disable ();
+	s = find_site (caller);
+	if (s != NULL) {
+		s->is_lock = is_lock;
+		s->acquired++;
+		if (contended) {
+			s->contended++;
+			s->wait_tsc += wait_tsc;
+			if (wait_tsc > s->max_wait_tsc)
+				s->max_wait_tsc = wait_tsc;
+		}
+	} else
+		dropped++;
+	intr_set_level (old_level);
+	return s;
+}
+
+/* Records that a lock taken at site S was held HOLD_TSC cycles. */
+void
+lockstat_record_hold (struct lockstat_site *s, uint64_t hold_tsc) {
+	enum intr_level old_level = intr_disable ();
+
+	if (hold_tsc > s->max_hold_tsc)
+		s->max_hold_tsc = hold_tsc;
+	intr_set_level (old_level);
+}
+
+/* Prints the TOP_N call sites with the most contended
+   acquisitions, most contended first. */
+void
+lockstat_print (int top_n) {
+	bool printed[LOCKSTAT_SITES] = { false };
+	int n;
+
+	if (!lockstat_enabled)
+		return;
+
+	printf ("Lockstat: top %d contended sites "
+			"(run the addresses through backtrace):\n", top_n);
+	for (n = 0; n < top_n; n++) {
+		struct lockstat_site *best = NULL;
+		size_t i;
+
+		/* Selection by repeated scans; the table is small and
+		   this only runs on demand. */
+		for (i = 0; i < LOCKSTAT_SITES; i++) {
+			struct lockstat_site *s = &sites[i];
+			if (s->caller != 0 && s->contended != 0 && !printed[i]
+					&& (best == NULL || s->contended > best->contended))
+				best = s;
+		}
+		if (best == NULL)
+			break;
+		printed[best - sites] = true;
+
+		printf ("Lockstat: %p %s: %llu acquired, %llu contended, "
+				"wait %llu us total %llu us max",
+				(void *) best->caller, best->is_lock ? "lock" : "sema",
+				best->acquired, best->contended,
+				timer_tsc_to_us (best->wait_tsc),
+				timer_tsc_to_us (best->max_wait_tsc));
+		if (best->is_lock)
+			printf (", hold %llu us max",
+					timer_tsc_to_us (best->max_hold_tsc));
+		printf ("\n");
+	}
+	if (dropped != 0)
+		printf ("Lockstat: %llu acquisitions from untracked sites\n", dropped);
+}
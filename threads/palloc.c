@@ -328,6 +328,33 @@ palloc_free_page (void *page) {
 	palloc_free_multiple (page, 1);
 }
 
+/* Returns the number of pages in the user pool, including pages
+   that were never usable. */
+size_t
+palloc_user_page_cnt (void) {
+	return bitmap_size (user_pool.used_map);
+}
+
+/* Returns the number of free pages in the user pool. */
+size_t
+palloc_user_free_cnt (void) {
+	size_t cnt;
+
+	lock_acquire (&user_pool.lock);
+	cnt = bitmap_count (user_pool.used_map, 0,
+			bitmap_size (user_pool.used_map), false);
+	lock_release (&user_pool.lock);
+	return cnt;
+}
+
+/* Returns the index of PAGE, which must be in the user pool,
+   counting from the start of the pool. */
+size_t
+palloc_user_page_idx (void *page) {
+	ASSERT (page_from_pool (&user_pool, page));
+	return pg_no (page) - pg_no (user_pool.base);
+}
+
 /* Initializes pool P as starting at START and ending at END */
 static void
 init_pool (struct pool *p, void **bm_base, uint64_t start, uint64_t end) {
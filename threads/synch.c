@@ -30,9 +30,45 @@
 #include <stdio.h>
 #include <string.h>
 #include "threads/interrupt.h"
+#include "threads/lockstat.h"
 #include "threads/thread.h"
+#include "intrinsic.h"
 
 
+/* Orders waiting threads by priority. */
+static bool
+waiter_less (const struct heap_elem *a, const struct heap_elem *b,
+		void *aux UNUSED) {
+	return heap_entry (a, struct thread, wait_elem)->priority
+		< heap_entry (b, struct thread, wait_elem)->priority;
+}
+
+/* Queues the current thread on WAITERS.  thread_requeue() keeps
+   it in place if its priority changes while it waits.  Interrupts
+   must be off. */
+static void
+waiter_push (struct heap *waiters) {
+	struct thread *curr = thread_current ();
+
+	ASSERT (intr_get_level () == INTR_OFF);
+	ASSERT (curr->wait_heap == NULL);
+
+	heap_push (waiters, &curr->wait_elem);
+	curr->wait_heap = waiters;
+}
+
+/* Removes and returns the highest-priority thread on WAITERS,
+   which must not be empty.  Interrupts must be off. */
+static struct thread *
+waiter_pop (struct heap *waiters) {
+	struct thread *t =
+		heap_entry (heap_pop (waiters), struct thread, wait_elem);
+
+	ASSERT (intr_get_level () == INTR_OFF);
+	t->wait_heap = NULL;
+	return t;
+}
+
 /* Initializes semaphore SEMA to VALUE.  A semaphore is a
    nonnegative integer along with two atomic operators for
    manipulating it:
@@ -47,13 +83,7 @@ sema_init (struct semaphore *sema, unsigned value) {
 	ASSERT (sema != NULL);
 
 	sema->value = value;
-	list_init (&sema->waiters);
-}
-
-bool search_sema_priority(const struct list_elem *a, const struct list_elem *b, void *aux UNUSED) {
-	struct thread *thread_a = list_entry(a, struct thread, elem);
-	struct thread *thread_b = list_entry(b, struct thread, elem);
-	return thread_a->priority > thread_b->priority;
+	heap_init (&sema->waiters, waiter_less, NULL);
 }
 
 /* Down or "P" operation on a semaphore.  Waits for SEMA's value
@@ -67,17 +97,23 @@ bool search_sema_priority(const struct list_elem *a, const struct list_elem *b,
 void
 sema_down (struct semaphore *sema) {
 	enum intr_level old_level;
+	bool contended;
+	uint64_t start;
 
 	ASSERT (sema != NULL);
 	ASSERT (!intr_context ());
 
 	old_level = intr_disable ();
+	contended = sema->value == 0;
+	start = lockstat_enabled ? rdtsc () : 0;
 	while (sema->value == 0) {
-		//list_push_back (&sema->waiters, &thread_current ()->elem);
-		list_insert_ordered(&sema->waiters, &thread_current ()->elem, &search_sema_priority,NULL);
+		waiter_push (&sema->waiters);
 		thread_block ();
 	}
 	sema->value--;
+	if (lockstat_enabled)
+		lockstat_record ((uintptr_t) __builtin_return_address (0), false,
+				contended, rdtsc () - start);
 	intr_set_level (old_level);
 }
 
@@ -118,12 +154,8 @@ sema_up (struct semaphore *sema) {
 
 	old_level = intr_disable ();
 	sema->value++; //////////
-	if (!list_empty (&sema->waiters))
-	{
-		list_sort(&sema->waiters,&search_sema_priority,NULL);
-		thread_unblock (list_entry (list_pop_front (&sema->waiters),
-					struct thread, elem));
-	}
+	if (!heap_empty (&sema->waiters))
+		thread_unblock (waiter_pop (&sema->waiters));
 	intr_set_level (old_level);
 }
 
@@ -162,6 +194,79 @@ sema_test_helper (void *sema_) {
 	}
 }
 
+/* Maximum length of a donation chain that is followed. */
+#define DONATION_DEPTH 8
+
+/* Returns the priority HOLD donates to its holder: that of the
+   highest-priority waiter, or PRI_MIN - 1 if there is none. */
+static int
+hold_priority (const struct lock_hold *hold) {
+	if (heap_empty (hold->waiters))
+		return PRI_MIN - 1;
+	return heap_entry (heap_top (hold->waiters), struct thread,
+			wait_elem)->priority;
+}
+
+/* Orders a thread's held locks by the priority they donate. */
+static bool
+hold_priority_less (const struct heap_elem *a, const struct heap_elem *b,
+		void *aux UNUSED) {
+	return hold_priority (heap_entry (a, struct lock_hold, elem))
+		< hold_priority (heap_entry (b, struct lock_hold, elem));
+}
+
+/* Initializes HELD, a thread's heap of held locks. */
+void
+held_locks_init (struct heap *held) {
+	heap_init (held, hold_priority_less, NULL);
+}
+
+static void lock_donate (struct lock *, int depth);
+static void rwlock_donate (struct rwlock *, int depth);
+
+/* Recomputes T's priority as the greater of its own and the one
+   donated by the locks it holds.  If that changes it, the change
+   is passed on to the holders of the lock T is waiting for, and
+   so on down the chain, DEPTH being T's place in it.  Interrupts
+   must be off. */
+static void
+priority_update (struct thread *t, int depth) {
+	int priority = t->origin_priority;
+
+	ASSERT (intr_get_level () == INTR_OFF);
+
+	if (depth >= DONATION_DEPTH)
+		return;
+	if (!heap_empty (&t->held_locks)) {
+		int donated = hold_priority (heap_entry (heap_top (&t->held_locks),
+					struct lock_hold, elem));
+		if (donated > priority)
+			priority = donated;
+	}
+	if (priority == t->priority)
+		return;
+
+	/* Moves T within the ready queues or the waiters of the lock
+	   it is waiting for. */
+	thread_requeue (t, priority);
+
+	if (t->waiting_lock != NULL)
+		lock_donate (t->waiting_lock, depth + 1);
+	if (t->waiting_rwlock != NULL)
+		rwlock_donate (t->waiting_rwlock, depth + 1);
+}
+
+/* Passes a change in the waiters of LOCK on to its holder. */
+static void
+lock_donate (struct lock *lock, int depth) {
+	struct thread *holder = lock->holder;
+
+	if (holder == NULL)
+		return;
+	heap_update (&holder->held_locks, &lock->hold.elem);
+	priority_update (holder, depth);
+}
+
 /* Initializes LOCK.  A lock can be held by at most a single
    thread at any given time.  Our locks are not "recursive", that
    is, it is an error for the thread currently holding a lock to
@@ -183,6 +288,26 @@ lock_init (struct lock *lock) {
 
 	lock->holder = NULL;
 	sema_init (&lock->semaphore, 1);
+	lock->hold.waiters = &lock->semaphore.waiters;
+	lock->stat_site = NULL;
+}
+
+/* Makes the current thread the holder of LOCK, whose semaphore
+   it has just downed.  Interrupts must be off. */
+static void
+lock_take (struct lock *lock) {
+	struct thread *curr = thread_current ();
+
+	ASSERT (intr_get_level () == INTR_OFF);
+
+	lock->holder = curr;
+	if (lock->stat_site != NULL)
+		lock->stat_tsc = rdtsc ();
+	if (!thread_mlfqs) {
+		/* Threads still waiting for LOCK now donate to us. */
+		heap_push (&curr->held_locks, &lock->hold.elem);
+		priority_update (curr, 0);
+	}
 }
 
 /* Acquires LOCK, sleeping until it becomes available if
@@ -195,25 +320,37 @@ lock_init (struct lock *lock) {
    we need to sleep. */
 void
 lock_acquire (struct lock *lock) {
+	struct thread *curr = thread_current ();
+	enum intr_level old_level;
+	bool contended;
+	uint64_t start;
+
 	ASSERT (lock != NULL);
 	ASSERT (!intr_context ());
 	ASSERT (!lock_held_by_current_thread (lock));
-	// 현재 스레드가 lock을 가지고 있고,
-	// 현재 스레드의 우선순위가 들어오는 스레드보다 작다면 
-	// donation 해야함
-	struct thread *curr = thread_current();
-	if (lock->holder) {
-		curr->waiting_lock = lock; // 현재 스레드가 왜 기부하는지(어떤 lock 기다리는지) 저장
-		//printf("들어왔니\n");
-		list_insert_ordered(&lock->holder->donation_list, &(curr->donation_elem), 
-							&high_donation_priority, NULL);
-		//printf("정렬했니\n");
-		donate_priority();
-	}
-	sema_down (&lock->semaphore);
 
-	curr->waiting_lock = NULL; // 기부했으면 지워줌
-	lock->holder = curr;
+	old_level = intr_disable ();
+	contended = lock->semaphore.value == 0;
+	start = lockstat_enabled ? rdtsc () : 0;
+	while (lock->semaphore.value == 0) {
+		waiter_push (&lock->semaphore.waiters);
+		// lock을 가진 스레드에게 우선순위를 기부함
+		// 우리가 lock의 최고 대기자가 되었다면 holder와 그 뒤의 체인의 우선순위가 오름
+		if (!thread_mlfqs && lock->holder != NULL) {
+			curr->waiting_lock = lock; // 현재 스레드가 왜 기부하는지(어떤 lock 기다리는지) 저장
+			lock_donate (lock, 0);
+		}
+		thread_block ();
+		curr->waiting_lock = NULL; // 깨어났으면 지워줌
+	}
+	lock->semaphore.value--;
+	lock->stat_site = NULL;
+	if (lockstat_enabled)
+		lock->stat_site = lockstat_record (
+				(uintptr_t) __builtin_return_address (0), true,
+				contended, rdtsc () - start);
+	lock_take (lock);
+	intr_set_level (old_level);
 }
 
 /* Tries to acquires LOCK and returns true if successful or false
@@ -224,42 +361,33 @@ lock_acquire (struct lock *lock) {
    interrupt handler. */
 bool
 lock_try_acquire (struct lock *lock) {
+	enum intr_level old_level;
 	bool success;
 
 	ASSERT (lock != NULL);
 	ASSERT (!lock_held_by_current_thread (lock));
 
+	old_level = intr_disable ();
 	success = sema_try_down (&lock->semaphore);
-	if (success)
-		lock->holder = thread_current ();
-	return success;
-}
-
-// donation list에서 스레드 제거하는 함수
-void remove_with_lock(struct lock *lock) {
-	struct list_elem *e;
-	struct thread *curr = thread_current();
-
-	for (e = list_begin(&curr->donation_list); e != list_end(&curr->donation_list); e = list_next(e)) {
-		struct thread *t = list_entry(e, struct thread, donation_elem);
-		if (t->waiting_lock == lock)
-			list_remove(&t->donation_elem);
+	if (success) {
+		lock->stat_site = NULL;
+		if (lockstat_enabled)
+			lock->stat_site = lockstat_record (
+					(uintptr_t) __builtin_return_address (0), true, false, 0);
+		lock_take (lock);
 	}
+	intr_set_level (old_level);
+	return success;
 }
 
-// donation_list에서 우선순위를 재설정해주는 함수
+// 현재 스레드의 우선순위를 원래 우선순위와 기부받은 우선순위로 재설정해주는 함수
 void refresh_priority(void) {
-	struct thread *curr = thread_current();
-
-	curr->priority = curr->origin_priority;
+	enum intr_level old_level = intr_disable ();
 
-	if(!list_empty(&curr->donation_list)) {
-		list_sort(&curr->donation_list, &high_donation_priority,NULL);
-		struct thread *front = list_entry(list_front(&curr->donation_list), struct thread, donation_elem);
-		if (front->priority > curr->priority)
-			curr->priority = front->priority;
-	}
+	priority_update (thread_current (), 0);
+	intr_set_level (old_level);
 }
+
 /* Releases LOCK, which must be owned by the current thread.
    This is lock_release function.
 
@@ -268,14 +396,23 @@ void refresh_priority(void) {
    handler. */
 void
 lock_release (struct lock *lock) {
+	enum intr_level old_level;
+
 	ASSERT (lock != NULL);
 	ASSERT (lock_held_by_current_thread (lock));
 
-	remove_with_lock(lock);
-	refresh_priority();
+	old_level = intr_disable ();
+	if (!thread_mlfqs) {
+		// LOCK을 기다리던 스레드들의 기부를 되돌림
+		heap_remove (&thread_current ()->held_locks, &lock->hold.elem);
+		priority_update (thread_current (), 0);
+	}
+	if (lock->stat_site != NULL)
+		lockstat_record_hold (lock->stat_site, rdtsc () - lock->stat_tsc);
 
 	lock->holder = NULL;
 	sema_up (&lock->semaphore);
+	intr_set_level (old_level);
 }
 
 /* Returns true if the current thread holds LOCK, false
@@ -288,25 +425,256 @@ lock_held_by_current_thread (const struct lock *lock) {
 
 	return lock->holder == thread_current ();
 }
-
-/* 세마포어를 리스트에 저장하기 위한 구조체 */
-struct semaphore_elem {
-	struct list_elem elem;              /* List element. */
-	struct semaphore semaphore;         /* This semaphore. */
-};
-
-bool cmp_sema_priority(const struct list_elem *a, const struct list_elem *b, void *aux UNUSED)
-{
-	//semaphore_elem의 list elem를 인자로 받아서, sema
-	struct semaphore_elem *sema_a = list_entry(a, struct semaphore_elem, elem);
-	struct semaphore_elem *sema_b = list_entry(b, struct semaphore_elem, elem);
-
-	struct list_elem *sema_elem_a = list_begin(&(sema_a->semaphore.waiters));
-	struct list_elem *sema_elem_b = list_begin(&(sema_b->semaphore.waiters));
-	// waiters에서 대기 중인 스레드들의 우선순위 구하기
-	struct thread *thread_a = list_entry(sema_elem_a, struct thread, elem);
-	struct thread *thread_b = list_entry(sema_elem_b, struct thread, elem);
-	return thread_a->priority > thread_b->priority;
+
+/* Initializes RWLOCK, which is initially held by no one. */
+void
+rwlock_init (struct rwlock *rw) {
+	ASSERT (rw != NULL);
+
+	rw->writer = NULL;
+	rw->readers = 0;
+	rw->writers_waiting = 0;
+	heap_init (&rw->waiters, waiter_less, NULL);
+	list_init (&rw->read_holds);
+	rw->hold.waiters = &rw->waiters;
+}
+
+/* Passes a change in the waiters of RW on to the writer or to
+   every reader holding it. */
+static void
+rwlock_donate (struct rwlock *rw, int depth) {
+	struct list_elem *e;
+
+	if (thread_mlfqs)
+		return;
+	if (rw->writer != NULL) {
+		heap_update (&rw->writer->held_locks, &rw->hold.elem);
+		priority_update (rw->writer, depth);
+	}
+	for (e = list_begin (&rw->read_holds); e != list_end (&rw->read_holds);
+			e = list_next (e)) {
+		struct rwlock_hold *h = list_entry (e, struct rwlock_hold, elem);
+		heap_update (&h->reader->held_locks, &h->hold.elem);
+		priority_update (h->reader, depth);
+	}
+}
+
+/* Returns T's read hold on RW, or NULL if T does not hold RW to
+   read. */
+static struct rwlock_hold *
+rwlock_find_hold (struct thread *t, const struct rwlock *rw) {
+	int i;
+
+	for (i = 0; i < RWLOCK_HOLD_MAX; i++)
+		if (t->rw_holds[i].rwlock == rw)
+			return &t->rw_holds[i];
+	return NULL;
+}
+
+/* Grants RW to T for reading.  Interrupts must be off. */
+static void
+rwlock_grant_read (struct rwlock *rw, struct thread *t) {
+	struct rwlock_hold *h = rwlock_find_hold (t, NULL);
+
+	ASSERT (intr_get_level () == INTR_OFF);
+	if (h == NULL)
+		PANIC ("%s holds more than %d rwlocks to read",
+				t->name, RWLOCK_HOLD_MAX);
+
+	rw->readers++;
+	h->rwlock = rw;
+	h->depth = 1;
+	h->reader = t;
+	h->hold.waiters = &rw->waiters;
+	list_push_back (&rw->read_holds, &h->elem);
+	if (!thread_mlfqs) {
+		heap_push (&t->held_locks, &h->hold.elem);
+		priority_update (t, 0);
+	}
+}
+
+/* Grants RW to T for writing.  Interrupts must be off. */
+static void
+rwlock_grant_write (struct rwlock *rw, struct thread *t) {
+	ASSERT (intr_get_level () == INTR_OFF);
+
+	rw->writer = t;
+	if (!thread_mlfqs) {
+		heap_push (&t->held_locks, &rw->hold.elem);
+		priority_update (t, 0);
+	}
+}
+
+/* Queues the current thread on RW and sleeps until a releasing
+   thread grants RW to it.  Interrupts must be off. */
+static void
+rwlock_wait (struct rwlock *rw, bool write) {
+	struct thread *curr = thread_current ();
+
+	curr->waiting_rwlock = rw;
+	curr->waiting_write = write;
+	if (write)
+		rw->writers_waiting++;
+	waiter_push (&rw->waiters);
+	rwlock_donate (rw, 0);
+	while (curr->wait_heap == &rw->waiters)
+		thread_block ();
+}
+
+/* Hands RW, which has just become free, to the waiter with the
+   highest priority.  If that is a reader, every reader queued
+   ahead of the first waiting writer gets RW too.  Interrupts
+   must be off. */
+static void
+rwlock_wake (struct rwlock *rw) {
+	struct list granted;
+
+	ASSERT (intr_get_level () == INTR_OFF);
+	ASSERT (rw->writer == NULL && rw->readers == 0);
+
+	/* Grant first and wake afterward: thread_unblock() may switch
+	   to a woken thread before we are done. */
+	list_init (&granted);
+	while (!heap_empty (&rw->waiters)) {
+		struct thread *t =
+			heap_entry (heap_top (&rw->waiters), struct thread, wait_elem);
+
+		if (t->waiting_write) {
+			if (rw->readers > 0)
+				break;
+			waiter_pop (&rw->waiters);
+			rw->writers_waiting--;
+			t->waiting_rwlock = NULL;
+			rwlock_grant_write (rw, t);
+			list_push_back (&granted, &t->elem);
+			break;
+		}
+		waiter_pop (&rw->waiters);
+		t->waiting_rwlock = NULL;
+		rwlock_grant_read (rw, t);
+		list_push_back (&granted, &t->elem);
+	}
+
+	/* Each pop above lowered the key of the read holds granted
+	   before it, so reorder those readers' held_locks and redo
+	   their donations. */
+	if (rw->readers > 0)
+		rwlock_donate (rw, 0);
+
+	while (!list_empty (&granted)) {
+		struct thread *t =
+			list_entry (list_pop_front (&granted), struct thread, elem);
+		if (t->status == THREAD_BLOCKED)
+			thread_unblock (t);
+	}
+}
+
+/* Acquires RW for reading, sleeping while a writer holds it or
+   waits for it.  The current thread must not hold RW to write,
+   but it may already hold it to read, in which case it does not
+   wait: writers are waiting for it anyway.
+
+   This function may sleep, so it must not be called within an
+   interrupt handler. */
+void
+rwlock_acquire_read (struct rwlock *rw) {
+	struct thread *curr = thread_current ();
+	struct rwlock_hold *h;
+	enum intr_level old_level;
+
+	ASSERT (rw != NULL);
+	ASSERT (!intr_context ());
+	ASSERT (rw->writer != curr);
+
+	old_level = intr_disable ();
+	h = rwlock_find_hold (curr, rw);
+	if (h != NULL)
+		h->depth++;
+	else if (rw->writer == NULL && rw->writers_waiting == 0)
+		rwlock_grant_read (rw, curr);
+	else
+		rwlock_wait (rw, false);
+	intr_set_level (old_level);
+}
+
+/* Releases RW, which the current thread must hold for reading. */
+void
+rwlock_release_read (struct rwlock *rw) {
+	struct thread *curr = thread_current ();
+	struct rwlock_hold *h;
+	enum intr_level old_level;
+
+	ASSERT (rw != NULL);
+
+	old_level = intr_disable ();
+	h = rwlock_find_hold (curr, rw);
+	ASSERT (h != NULL);
+	if (--h->depth > 0) {
+		intr_set_level (old_level);
+		return;
+	}
+
+	list_remove (&h->elem);
+	h->rwlock = NULL;
+	if (!thread_mlfqs) {
+		heap_remove (&curr->held_locks, &h->hold.elem);
+		priority_update (curr, 0);
+	}
+	if (--rw->readers == 0)
+		rwlock_wake (rw);
+	intr_set_level (old_level);
+}
+
+/* Acquires RW for writing, sleeping until no one else holds it.
+   The current thread must not already hold RW.
+
+   This function may sleep, so it must not be called within an
+   interrupt handler. */
+void
+rwlock_acquire_write (struct rwlock *rw) {
+	struct thread *curr = thread_current ();
+	enum intr_level old_level;
+
+	ASSERT (rw != NULL);
+	ASSERT (!intr_context ());
+	ASSERT (!rwlock_held_by_current_thread (rw));
+
+	old_level = intr_disable ();
+	if (rw->writer == NULL && rw->readers == 0)
+		rwlock_grant_write (rw, curr);
+	else
+		rwlock_wait (rw, true);
+	intr_set_level (old_level);
+}
+
+/* Releases RW, which the current thread must hold for writing. */
+void
+rwlock_release_write (struct rwlock *rw) {
+	struct thread *curr = thread_current ();
+	enum intr_level old_level;
+
+	ASSERT (rw != NULL);
+	ASSERT (rw->writer == curr);
+
+	old_level = intr_disable ();
+	rw->writer = NULL;
+	if (!thread_mlfqs) {
+		heap_remove (&curr->held_locks, &rw->hold.elem);
+		priority_update (curr, 0);
+	}
+	rwlock_wake (rw);
+	intr_set_level (old_level);
+}
+
+/* Returns true if the current thread holds RW, for reading or
+   writing. */
+bool
+rwlock_held_by_current_thread (const struct rwlock *rw) {
+	struct thread *curr = thread_current ();
+
+	ASSERT (rw != NULL);
+
+	return rw->writer == curr || rwlock_find_hold (curr, rw) != NULL;
 }
 
 /* Initializes condition variable COND.  A condition variable
@@ -316,7 +684,7 @@ void
 cond_init (struct condition *cond) {
 	ASSERT (cond != NULL);
 
-	list_init (&cond->waiters);
+	heap_init (&cond->waiters, waiter_less, NULL);
 }
 
 /* LOCK을 자동으로 해제하고 COND가 다른 코드 조각에 의해 신호를 받을 때까지 기다립니다. 
@@ -331,18 +699,24 @@ cond_init (struct condition *cond) {
 	절전 모드가 필요한 경우 인터럽트가 다시 켜집니다. */
 void
 cond_wait (struct condition *cond, struct lock *lock) {
-	struct semaphore_elem waiter;
+	struct thread *curr = thread_current ();
+	enum intr_level old_level;
 
 	ASSERT (cond != NULL);
 	ASSERT (lock != NULL);
 	ASSERT (!intr_context ());
 	ASSERT (lock_held_by_current_thread (lock));
 
-	sema_init (&waiter.semaphore, 0);
-	// list_push_back (&cond->waiters, &waiter.elem);
-	list_insert_ordered(&cond->waiters, &waiter.elem, cmp_sema_priority, NULL);
+	/* The waiting thread itself sits in COND's heap, so that its
+	   place follows its priority.  Releasing LOCK may preempt us
+	   before we block; cond_signal() then just takes us off the
+	   heap and we do not block at all. */
+	old_level = intr_disable ();
+	waiter_push (&cond->waiters);
 	lock_release (lock);
-	sema_down (&waiter.semaphore);
+	while (curr->wait_heap == &cond->waiters)
+		thread_block ();
+	intr_set_level (old_level);
 	lock_acquire (lock);
 }
 
@@ -355,17 +729,20 @@ cond_wait (struct condition *cond, struct lock *lock) {
    interrupt handler. */
 void
 cond_signal (struct condition *cond, struct lock *lock UNUSED) {
+	enum intr_level old_level;
+
 	ASSERT (cond != NULL);
 	ASSERT (lock != NULL);
 	ASSERT (!intr_context ());
 	ASSERT (lock_held_by_current_thread (lock));
 
-	if (!list_empty (&cond->waiters))
-	{
-		 list_sort(&cond->waiters, cmp_sema_priority, NULL);
-		 sema_up (&list_entry (list_pop_front (&cond->waiters),
-					struct semaphore_elem, elem)->semaphore);
+	old_level = intr_disable ();
+	if (!heap_empty (&cond->waiters)) {
+		struct thread *t = waiter_pop (&cond->waiters);
+		if (t->status == THREAD_BLOCKED)
+			thread_unblock (t);
 	}
+	intr_set_level (old_level);
 }
 
 /* Wakes up all threads, if any, waiting on COND (protected by
@@ -379,6 +756,6 @@ cond_broadcast (struct condition *cond, struct lock *lock) {
 	ASSERT (cond != NULL);
 	ASSERT (lock != NULL);
 
-	while (!list_empty (&cond->waiters))
+	while (!heap_empty (&cond->waiters))
 		cond_signal (cond, lock);
 }
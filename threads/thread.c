@@ -11,6 +11,7 @@
 #include "threads/synch.h"
 #include "threads/vaddr.h"
 #include "intrinsic.h"
+#include "devices/timer.h"
 #include "filesys/directory.h"
 #ifdef USERPROG
 #include "userprog/process.h"
@@ -25,10 +26,17 @@
    Do not modify this value. */
 #define THREAD_BASIC 0xd42df210
 
-/* List of processes in THREAD_READY state, that is, processes
-   that are ready to run but not actually running. */
-static struct list ready_list;
-static struct list sleep_list;
+/* Processes in THREAD_READY state, that is, processes that are
+   ready to run but not actually running.  There is one FIFO queue
+   per priority level, and bit N of ready_mask is set whenever
+   ready_queues[N] is non-empty, so the highest ready priority is
+   found with a single bit scan. */
+static struct list ready_queues[PRI_MAX + 1];
+static uint64_t ready_mask;
+static int ready_cnt;           /* # of threads in ready_queues. */
+
+/* List of all live threads. */
+static struct list all_list;
 
 
 /* Idle thread. */
@@ -43,11 +51,24 @@ static struct lock tid_lock;
 /* Thread destruction requests */
 static struct list destruction_req;
 
+/* Pages of dead threads kept for reuse by thread_create(), linked
+   through their struct thread's elem, so that spawning short-lived
+   threads does not go back to the page allocator every time.
+   Only touched with interrupts off. */
+#define THREAD_CACHE_MAX 16
+static struct list thread_cache;
+static size_t thread_cache_cnt;
+
 /* Statistics. */
 static long long idle_ticks;    /* # of timer ticks spent idle. */
 static long long kernel_ticks;  /* # of timer ticks in kernel threads. */
 static long long user_ticks;    /* # of timer ticks in user programs. */
 
+/* Wakeup-to-run latency histogram over all threads, including
+   ones that have exited.  See <schedstat.h> for the buckets. */
+static long long latency_hist[SCHED_LAT_BUCKETS];
+static uint64_t max_latency_tsc;
+
 /* Scheduling. */
 #define TIME_SLICE 4            /* # of timer ticks to give each thread. */
 static unsigned thread_ticks;   /* # of timer ticks since last yield. */
@@ -57,15 +78,43 @@ static unsigned thread_ticks;   /* # of timer ticks since last yield. */
    Controlled by kernel command-line option "-o mlfqs". */
 bool thread_mlfqs;
 
+/* 4.4BSD scheduler state.
+   recent_cpu is decayed once per second by a coefficient that
+   depends on load_avg.  The timer interrupt never walks every
+   thread at once: each second only records the new coefficient
+   in decay_history and decays the running thread, and a sweep
+   then works through all_list MLFQS_SWEEP_BATCH threads per tick,
+   bringing each up to date and requeuing it if it is ready.
+   Threads are also brought up to date whenever they are unblocked
+   or created from, so a thread's lag is bounded by how long one
+   sweep takes, which must stay within the history. */
+#define MLFQS_HISTORY 64                /* Seconds of decay coefficients kept. */
+#define MLFQS_SWEEP_BATCH 8             /* Threads swept per tick. */
+#define MLFQS_PRI_INTERVAL 4            /* Ticks between priority updates. */
+static fixed_t load_avg;                /* System load average. */
+static int64_t decay_epoch;             /* # of per-second decays so far. */
+static fixed_t decay_history[MLFQS_HISTORY];
+static struct list_elem *sweep_next;    /* Next in all_list to sweep,
+                                           or NULL between sweeps. */
+
 static void kernel_thread (thread_func *, void *aux);
 
 static void idle (void *aux UNUSED);
 static struct thread *next_thread_to_run (void);
 static void init_thread (struct thread *, const char *name, int priority);
 static void do_schedule(int status);
+static struct thread *thread_page_alloc (void);
+static void thread_page_free (struct thread *);
 static void schedule (void);
 static tid_t allocate_tid (void);
-static struct thread *search_highest_priority (void);
+static void ready_queue_push (struct thread *);
+static void ready_queue_remove (struct thread *);
+static int ready_queue_max_priority (void);
+static void mlfqs_catch_up (struct thread *);
+static void mlfqs_update_priority (struct thread *);
+static void mlfqs_second (void);
+static void mlfqs_sweep (void);
+static void sched_stats_fill (struct thread *, struct sched_stats *);
 
 /* Returns true if T appears to point to a valid thread. */
 #define is_thread(t) ((t) != NULL && (t)->magic == THREAD_MAGIC)
@@ -111,16 +160,21 @@ thread_init (void) {
 
 	/* Init the globla thread context */
 	lock_init (&tid_lock);
-	list_init (&ready_list);
-	list_init (&sleep_list);
+	for (int i = PRI_MIN; i <= PRI_MAX; i++)
+		list_init (&ready_queues[i]);
+	ready_mask = 0;
+	list_init (&all_list);
 	list_init (&destruction_req);
+	list_init (&thread_cache);
 
 	/* Set up a thread structure for the running thread. */
 	initial_thread = running_thread ();
 	init_thread (initial_thread, "main", PRI_DEFAULT);
 	initial_thread->status = THREAD_RUNNING;
+	initial_thread->sched_in_tsc = rdtsc ();
 	initial_thread->tid = allocate_tid ();
 	initial_thread->cur_dir = NULL;
+	list_push_back (&all_list, &initial_thread->all_elem);
 }
 
 /* Starts preemptive thread scheduling by enabling interrupts.
@@ -155,16 +209,125 @@ thread_tick (void) {
 	else
 		kernel_ticks++;
 
+	if (thread_mlfqs) {
+		int64_t now = timer_ticks ();
+
+		if (t != idle_thread)
+			t->recent_cpu = fp_add_int (t->recent_cpu, 1);
+		if (now % TIMER_FREQ == 0)
+			mlfqs_second ();
+		if (sweep_next != NULL)
+			mlfqs_sweep ();
+		if (now % MLFQS_PRI_INTERVAL == 0 && t != idle_thread) {
+			/* Between decays only the running thread's recent_cpu
+			   changes, so it is the only priority to recompute. */
+			mlfqs_update_priority (t);
+			if (t->priority < ready_queue_max_priority ())
+				intr_yield_on_return ();
+		}
+	}
+
 	/* Enforce preemption. */
 	if (++thread_ticks >= TIME_SLICE)
 		intr_yield_on_return ();
 }
 
+/* Accounts one timer tick that passed while the CPU was idle
+   and the timer interrupt was suppressed. */
+void
+thread_idle_tick (void) {
+	idle_ticks++;
+}
+
+/* Returns the latency histogram bucket for a wakeup-to-run
+   latency of CYCLES. */
+static int
+latency_bucket (uint64_t cycles) {
+	uint64_t us = timer_tsc_to_us (cycles);
+	int bucket;
+
+	if (us == 0)
+		return 0;
+	bucket = bsrq (us) + 1;
+	return bucket < SCHED_LAT_BUCKETS ? bucket : SCHED_LAT_BUCKETS - 1;
+}
+
 /* Prints thread statistics. */
 void
 thread_print_stats (void) {
+	struct list_elem *e;
+	enum intr_level old_level;
+	int i;
+
 	printf ("Thread: %lld idle ticks, %lld kernel ticks, %lld user ticks\n",
 			idle_ticks, kernel_ticks, user_ticks);
+
+	printf ("Thread: wakeup latency (max %llu us):",
+			timer_tsc_to_us (max_latency_tsc));
+	for (i = 0; i < SCHED_LAT_BUCKETS - 1; i++)
+		if (latency_hist[i] != 0)
+			printf (" <%dus:%lld", 1 << i, latency_hist[i]);
+	if (latency_hist[i] != 0)
+		printf (" >=%dus:%lld", 1 << (i - 1), latency_hist[i]);
+	printf ("\n");
+
+	/* Threads must not exit and be recycled under the walk. */
+	old_level = intr_disable ();
+	for (e = list_begin (&all_list); e != list_end (&all_list); e = list_next (e)) {
+		struct thread *t = list_entry (e, struct thread, all_elem);
+		struct sched_stats st;
+
+		sched_stats_fill (t, &st);
+		printf ("Thread: %s (tid %d): %llu us run, %llu voluntary, "
+				"%llu involuntary switches, max latency %llu us\n",
+				t->name, t->tid, st.run_us, st.voluntary_switches,
+				st.involuntary_switches, st.max_latency_us);
+	}
+	intr_set_level (old_level);
+}
+
+/* Fills ST with the scheduler statistics of T.  Interrupts must
+   be off. */
+static void
+sched_stats_fill (struct thread *t, struct sched_stats *st) {
+	uint64_t run_tsc;
+	int i;
+
+	ASSERT (intr_get_level () == INTR_OFF);
+
+	run_tsc = t->run_tsc;
+	if (t->status == THREAD_RUNNING)
+		run_tsc += rdtsc () - t->sched_in_tsc;
+	st->run_us = timer_tsc_to_us (run_tsc);
+	st->voluntary_switches = t->voluntary_switches;
+	st->involuntary_switches = t->involuntary_switches;
+	st->max_latency_us = timer_tsc_to_us (t->max_latency_tsc);
+	for (i = 0; i < SCHED_LAT_BUCKETS; i++)
+		st->latency[i] = t->latency_hist[i];
+}
+
+/* Fills ST with the scheduler statistics of the live thread with
+   the given TID.  Returns false if there is no such thread. */
+bool
+thread_get_sched_stats (tid_t tid, struct sched_stats *st) {
+	struct thread *t = NULL;
+	struct list_elem *e;
+	enum intr_level old_level;
+
+	old_level = intr_disable ();
+	for (e = list_begin (&all_list); e != list_end (&all_list); e = list_next (e))
+		if (list_entry (e, struct thread, all_elem)->tid == tid) {
+			t = list_entry (e, struct thread, all_elem);
+			break;
+		}
+	if (t == NULL) {
+		intr_set_level (old_level);
+		return false;
+	}
+
+	sched_stats_fill (t, st);
+	intr_set_level (old_level);
+	return true;
 }
 
 /* Creates a new kernel thread named NAME with the given initial
@@ -190,8 +353,9 @@ thread_create (const char *name, int priority,
 
 	ASSERT (function != NULL);
 
-	/* Allocate thread. */
-	t = palloc_get_page (PAL_ZERO);
+	/* Allocate thread.  init_thread() clears the struct thread, the
+	   rest of the page is stack and needs no zeroing. */
+	t = thread_page_alloc ();
 	if (t == NULL)
 		return TID_ERROR;
 
@@ -199,6 +363,20 @@ thread_create (const char *name, int priority,
 	init_thread (t, name, priority);
 	tid = t->tid = allocate_tid ();
 
+	enum intr_level old_level = intr_disable ();
+	if (thread_mlfqs) {
+		/* The 4.4BSD scheduler ignores PRIORITY; a new thread
+		   inherits its parent's niceness and recent_cpu. */
+		struct thread *parent = thread_current ();
+		mlfqs_catch_up (parent);
+		t->nice = parent->nice;
+		t->recent_cpu = parent->recent_cpu;
+		t->recent_cpu_epoch = decay_epoch;
+		mlfqs_update_priority (t);
+	}
+	list_push_back (&all_list, &t->all_elem);
+	intr_set_level (old_level);
+
 	/*project4 추가*/
 	#ifdef EFILESYS
     if(thread_current()->cur_dir != NULL) {
@@ -211,8 +389,9 @@ thread_create (const char *name, int priority,
 	list_push_back(&curr->child_list,&t->child_elem);
 
 	//2-4 file descriptor
-	//t->fdt = palloc_get_page(PAL_ZERO);//확인) multi-oom : need more pages to accomodate 10 stacks of 126 opens
-	t->fdt = palloc_get_multiple(PAL_ZERO,FDT_PAGES); //오ㅐ 3인지?
+	// 처음에는 struct thread 안의 작은 표를 쓰고, 부족하면 process_add_file()이 키운다
+	t->fdt = t->fdt_inline;
+	t->fdt_size = FDT_INLINE;
 	t->next_fd = 2; //0: stdin, 1 stdout
 
 	/* Call the kernel_thread if it scheduled.
@@ -262,7 +441,12 @@ thread_unblock (struct thread *t) {
 
 	old_level = intr_disable ();
 	ASSERT (t->status == THREAD_BLOCKED);
-	list_push_back (&ready_list, &t->elem);
+	if (thread_mlfqs) {
+		mlfqs_catch_up (t);
+		mlfqs_update_priority (t);
+	}
+	t->ready_tsc = rdtsc ();
+	ready_queue_push (t);
 	t->status = THREAD_READY;
 	// 지금 태어난 스레드가 우선순위가 현재 런하고 있는 스레드보다 크다면
 	// thread_yield()호출해서 양보
@@ -271,7 +455,10 @@ thread_unblock (struct thread *t) {
 	if (curr->status == THREAD_RUNNING) {
 		if (curr != idle_thread) {
 			if (t->priority > curr ->priority) {
-				thread_yield();
+				if (intr_context ())
+					intr_yield_on_return ();
+				else
+					thread_yield();
 			}
 		}	
 	}
@@ -321,6 +508,9 @@ thread_exit (void) {
 	/* Just set our status to dying and schedule another process.
 	   We will be destroyed during the call to schedule_tail(). */
 	intr_disable ();
+	if (sweep_next == &thread_current ()->all_elem)
+		sweep_next = list_next (sweep_next);
+	list_remove (&thread_current ()->all_elem);
 	do_schedule (THREAD_DYING);
 	NOT_REACHED ();
 }
@@ -336,7 +526,7 @@ thread_yield (void) {
 
 	old_level = intr_disable ();
 	if (curr != idle_thread)
-		list_push_back (&ready_list, &curr->elem);
+		ready_queue_push (curr);
 	do_schedule (THREAD_READY);
 	intr_set_level (old_level);
 }
@@ -344,14 +534,17 @@ thread_yield (void) {
 /* Sets the current thread's priority to NEW_PRIORITY. */
 void
 thread_set_priority (int new_priority) {
+	/* The 4.4BSD scheduler computes priorities itself. */
+	if (thread_mlfqs)
+		return;
+
 	thread_current ()->origin_priority = new_priority;
 	// 현재 레디 리스트 안에서 제일 높은 우선순위를 가진 스레드를 찾는다
 	// new(현재)랑 제일 높은 애(전체 레디리스트에서)랑 비교해
 	// new가 제일 높은 애보다 작으면
 	// yield()호출
 	refresh_priority();
-	struct thread *highest_priority= search_highest_priority();
-	if (new_priority < highest_priority) {
+	if (thread_current ()->priority < ready_queue_max_priority ()) {
 		thread_yield();
 	}
 }
@@ -364,29 +557,46 @@ thread_get_priority (void) {
 
 /* Sets the current thread's nice value to NICE. */
 void
-thread_set_nice (int nice UNUSED) {
-	/* TODO: Your implementation goes here */
+thread_set_nice (int nice) {
+	struct thread *curr = thread_current ();
+	enum intr_level old_level;
+
+	ASSERT (NICE_MIN <= nice && nice <= NICE_MAX);
+
+	old_level = intr_disable ();
+	mlfqs_catch_up (curr);
+	curr->nice = nice;
+	mlfqs_update_priority (curr);
+	intr_set_level (old_level);
+
+	if (curr->priority < ready_queue_max_priority ())
+		thread_yield ();
 }
 
 /* Returns the current thread's nice value. */
 int
 thread_get_nice (void) {
-	/* TODO: Your implementation goes here */
-	return 0;
+	return thread_current ()->nice;
 }
 
 /* Returns 100 times the system load average. */
 int
 thread_get_load_avg (void) {
-	/* TODO: Your implementation goes here */
-	return 0;
+	enum intr_level old_level = intr_disable ();
+	int load = fp_to_int_round (fp_mul_int (load_avg, 100));
+	intr_set_level (old_level);
+	return load;
 }
 
 /* Returns 100 times the current thread's recent_cpu value. */
 int
 thread_get_recent_cpu (void) {
-	/* TODO: Your implementation goes here */
-	return 0;
+	struct thread *curr = thread_current ();
+	enum intr_level old_level = intr_disable ();
+	mlfqs_catch_up (curr);
+	int recent = fp_to_int_round (fp_mul_int (curr->recent_cpu, 100));
+	intr_set_level (old_level);
+	return recent;
 }
 
 /* Idle thread.  Executes when no other thread is ready to run.
@@ -408,8 +618,13 @@ idle (void *idle_started_ UNUSED) {
 	for (;;) {
 		/* Let someone else run. */
 		intr_disable ();
+		timer_idle_exit ();
 		thread_block ();
 
+		/* Nothing else to run.  Let the timer skip the ticks in
+		   which no timeout is due. */
+		timer_idle_enter ();
+
 		/* Re-enable interrupts and wait for the next one.
 
 		   The `sti' instruction disables interrupts until the
@@ -453,7 +668,7 @@ init_thread (struct thread *t, const char *name, int priority) {
 	t->magic = THREAD_MAGIC;
 	t->origin_priority = priority;
 	t->waiting_lock = NULL;
-	list_init(&t->donation_list);
+	held_locks_init (&t->held_locks);
 
 	
 	/*project2 추가*/
@@ -465,11 +680,141 @@ init_thread (struct thread *t, const char *name, int priority) {
 	t->running = NULL;
 }
 
-bool priority_ready_list(const struct list_elem *a, const struct list_elem *b, void *aux UNUSED) {
-	struct thread *thread_a = list_entry(a, struct thread, elem);
-	struct thread *thread_b = list_entry(b, struct thread, elem);
-	return thread_a->priority > thread_b->priority;
+/* Appends T to the ready queue of its current priority. */
+static void
+ready_queue_push (struct thread *t) {
+	ASSERT (intr_get_level () == INTR_OFF);
+	ASSERT (PRI_MIN <= t->priority && t->priority <= PRI_MAX);
+
+	list_push_back (&ready_queues[t->priority], &t->elem);
+	ready_mask |= 1ULL << t->priority;
+	ready_cnt++;
+}
+
+/* Removes ready thread T from the ready queue of its current
+   priority.  T's priority must not have changed since it was
+   pushed. */
+static void
+ready_queue_remove (struct thread *t) {
+	ASSERT (intr_get_level () == INTR_OFF);
+	ASSERT (t->status == THREAD_READY);
+
+	list_remove (&t->elem);
+	if (list_empty (&ready_queues[t->priority]))
+		ready_mask &= ~(1ULL << t->priority);
+	ready_cnt--;
+}
+
+/* Returns the highest priority among the ready threads, or
+   PRI_MIN - 1 if no thread is ready. */
+static int
+ready_queue_max_priority (void) {
+	if (ready_mask == 0)
+		return PRI_MIN - 1;
+	return bsrq (ready_mask);
+}
+
+/* Changes T's priority to PRIORITY, moving T to the matching
+   ready queue if it is currently waiting to run, and to its new
+   place among the waiters of a semaphore or condition variable
+   if it is waiting on one. */
+void
+thread_requeue (struct thread *t, int priority) {
+	enum intr_level old_level = intr_disable ();
+
+	if (t->priority != priority) {
+		if (t->status == THREAD_READY) {
+			ready_queue_remove (t);
+			t->priority = priority;
+			ready_queue_push (t);
+		} else
+			t->priority = priority;
+		if (t->wait_heap != NULL)
+			heap_update (t->wait_heap, &t->wait_elem);
+	}
+	intr_set_level (old_level);
+}
+
+/* Applies every per-second recent_cpu decay that T has missed
+   since it was last brought up to date. */
+static void
+mlfqs_catch_up (struct thread *t) {
+	ASSERT (decay_epoch - t->recent_cpu_epoch <= MLFQS_HISTORY);
+
+	while (t->recent_cpu_epoch < decay_epoch) {
+		fixed_t coef = decay_history[++t->recent_cpu_epoch % MLFQS_HISTORY];
+		t->recent_cpu = fp_add_int (fp_mul (coef, t->recent_cpu), t->nice);
+	}
+}
+
+/* Recomputes T's priority from its recent_cpu and nice values,
+   moving T to its new ready queue if it is waiting to run. */
+static void
+mlfqs_update_priority (struct thread *t) {
+	int priority = PRI_MAX - fp_to_int (fp_div_int (t->recent_cpu, 4))
+		- t->nice * 2;
+
+	if (priority < PRI_MIN)
+		priority = PRI_MIN;
+	if (priority > PRI_MAX)
+		priority = PRI_MAX;
+	t->origin_priority = priority;
+	thread_requeue (t, priority);
+}
+
+/* Once-per-second 4.4BSD bookkeeping, run from the timer
+   interrupt: updates load_avg, records the new decay coefficient,
+   applies it to the running thread and starts a sweep of the
+   rest, unless the last one is still going. */
+static void
+mlfqs_second (void) {
+	struct thread *curr = thread_current ();
+	int ready_threads = ready_cnt + (curr != idle_thread ? 1 : 0);
+	fixed_t twice_load;
+
+	load_avg = fp_add (fp_mul (fp_div_int (int_to_fp (59), 60), load_avg),
+			fp_div_int (int_to_fp (ready_threads), 60));
+
+	twice_load = fp_mul_int (load_avg, 2);
+	decay_history[++decay_epoch % MLFQS_HISTORY] =
+		fp_div (twice_load, fp_add_int (twice_load, 1));
+
+	if (curr != idle_thread) {
+		mlfqs_catch_up (curr);
+		mlfqs_update_priority (curr);
+	}
+
+	if (sweep_next == NULL)
+		sweep_next = list_begin (&all_list);
+}
+
+/* Brings up to MLFQS_SWEEP_BATCH more threads of the current sweep
+   up to date, from the timer interrupt.  Ready threads move to
+   their new queues; blocked ones only need recent_cpu kept within
+   reach of decay_history, as their priority is recomputed on
+   unblock. */
+static void
+mlfqs_sweep (void) {
+	int i;
+
+	for (i = 0; i < MLFQS_SWEEP_BATCH; i++) {
+		struct thread *t;
+
+		if (sweep_next == list_end (&all_list)) {
+			sweep_next = NULL;
+			break;
+		}
+		t = list_entry (sweep_next, struct thread, all_elem);
+		sweep_next = list_next (sweep_next);
+		mlfqs_catch_up (t);
+		if (t->status == THREAD_READY)
+			mlfqs_update_priority (t);
+	}
+	if (thread_current () != idle_thread
+			&& thread_current ()->priority < ready_queue_max_priority ())
+		intr_yield_on_return ();
 }
+
 /* Chooses and returns the next thread to be scheduled.  Should
    return a thread from the run queue, unless the run queue is
    empty.  (If the running thread can continue running, then it
@@ -477,22 +822,20 @@ bool priority_ready_list(const struct list_elem *a, const struct list_elem *b, v
    idle_thread. */
 static struct thread *
 next_thread_to_run (void) {
-	if (list_empty (&ready_list))
-		return idle_thread;
-	else
-	// 우선순위로 정렬
-		list_sort(&ready_list, &priority_ready_list, NULL);
-		return list_entry (list_pop_front (&ready_list), struct thread, elem);
-}
+	int priority;
+	struct list *queue;
 
-static struct thread *
-search_highest_priority (void) {
-	if (list_empty (&ready_list))
+	if (ready_mask == 0)
 		return idle_thread;
-	else
-	// 우선순위로 정렬
-		list_sort(&ready_list, &priority_ready_list, NULL);
-		return list_entry (list_front (&ready_list), struct thread, elem);
+
+	// 비트맵에서 가장 높은 우선순위의 큐를 바로 찾는다
+	priority = bsrq (ready_mask);
+	queue = &ready_queues[priority];
+	struct thread *next = list_entry (list_pop_front (queue), struct thread, elem);
+	if (list_empty (queue))
+		ready_mask &= ~(1ULL << priority);
+	ready_cnt--;
+	return next;
 }
 
 /* Use iretq to launch the thread */
@@ -592,6 +935,39 @@ thread_launch (struct thread *th) {
 			);
 }
 
+/* Returns a page for a new thread, reusing the page of a dead
+   thread if one is cached.  The page is not zeroed.  Returns
+   NULL if no memory is available. */
+static struct thread *
+thread_page_alloc (void) {
+	struct thread *t = NULL;
+	enum intr_level old_level;
+
+	old_level = intr_disable ();
+	if (!list_empty (&thread_cache)) {
+		t = list_entry (list_pop_front (&thread_cache), struct thread, elem);
+		thread_cache_cnt--;
+	}
+	intr_set_level (old_level);
+
+	return t != NULL ? t : palloc_get_page (0);
+}
+
+/* Releases the page of dead thread T, keeping it in the cache if
+   there is room.  Interrupts must be off. */
+static void
+thread_page_free (struct thread *t) {
+	ASSERT (intr_get_level () == INTR_OFF);
+
+	/* Stale pointers to T must no longer look like a thread. */
+	t->magic = 0;
+	if (thread_cache_cnt < THREAD_CACHE_MAX) {
+		list_push_front (&thread_cache, &t->elem);
+		thread_cache_cnt++;
+	} else
+		palloc_free_page (t);
+}
+
 /* Schedules a new process. At entry, interrupts must be off.
  * This function modify current thread's status to status and then
  * finds another thread to run and switches to it.
@@ -603,7 +979,7 @@ do_schedule(int status) {
 	while (!list_empty (&destruction_req)) {
 		struct thread *victim =
 			list_entry (list_pop_front (&destruction_req), struct thread, elem);
-		palloc_free_page(victim);
+		thread_page_free (victim);
 	}
 	thread_current ()->status = status;
 	schedule ();
@@ -620,6 +996,30 @@ schedule (void) {
 	/* Mark us as running. */
 	next->status = THREAD_RUNNING;
 
+	if (curr != next) {
+		uint64_t now = rdtsc ();
+
+		curr->run_tsc += now - curr->sched_in_tsc;
+		if (curr->status == THREAD_READY)
+			curr->involuntary_switches++;
+		else
+			curr->voluntary_switches++;
+
+		next->sched_in_tsc = now;
+		if (next->ready_tsc != 0) {
+			uint64_t latency = now - next->ready_tsc;
+			int bucket = latency_bucket (latency);
+
+			next->latency_hist[bucket]++;
+			latency_hist[bucket]++;
+			if (latency > next->max_latency_tsc)
+				next->max_latency_tsc = latency;
+			if (latency > max_latency_tsc)
+				max_latency_tsc = latency;
+			next->ready_tsc = 0;
+		}
+	}
+
 	/* Start new time slice. */
 	thread_ticks = 0;
 
@@ -660,75 +1060,27 @@ allocate_tid (void) {
 	return tid;
 }
 
-bool less_by_wake_time(const struct list_elem *a, const struct list_elem *b, void *aux UNUSED) {
-	struct thread *thread_a = list_entry(a, struct thread, elem);
-	struct thread *thread_b = list_entry(b, struct thread, elem);
-	return thread_a->wake_time < thread_b->wake_time;
+/* Timeout callback that wakes the sleeping thread AUX. */
+static void
+thread_wake (void *aux) {
+	thread_unblock (aux);
 }
 
-
+/* Blocks the current thread until timer tick START + TICKS.
+   The wakeup is armed on the timer's timing wheel, so this is
+   O(1) regardless of how many threads are asleep. */
 void thread_sleep(int64_t start, int64_t ticks) {
     struct thread *cur_thread = thread_current ();
-    cur_thread->wake_time = start + ticks;
-
-    enum intr_level old_level = intr_disable();
+    struct timeout wakeup;
 
     ASSERT(!intr_context());
+    ASSERT(cur_thread != idle_thread);
 
-    if (cur_thread != idle_thread) {
-        list_insert_ordered(&sleep_list, &cur_thread->elem, &less_by_wake_time, NULL);
-    }
-
-    thread_block();
-
-    intr_set_level(old_level);
-}
+    cur_thread->wake_time = start + ticks;
+    timeout_init(&wakeup, thread_wake, cur_thread);
 
-void thread_wake(int64_t ticks) {
     enum intr_level old_level = intr_disable();
-    // wake 앞에 맨 앞의 최소값(front)을 찾아서 tick가 최소값보다 작으면 리턴 (while문 돌지 않음)
-    if (list_empty(&sleep_list)) {
-        intr_set_level(old_level);
-        return;
-    }
-
-    struct list_elem *e = list_front(&sleep_list);
-    struct thread *t = list_entry(e, struct thread, elem);
-    if (t->wake_time > ticks) {
-        intr_set_level(old_level);
-        return;
-    }
-
-    while (!list_empty(&sleep_list)) {
-        e = list_front(&sleep_list);
-        struct thread *awake_thread = list_entry(e, struct thread, elem);
-        if (awake_thread->wake_time > ticks) {
-            break;
-        }
-        list_remove(e);
-        thread_unblock(awake_thread);
-    }
-
+    timeout_arm(&wakeup, cur_thread->wake_time);
+    thread_block();
     intr_set_level(old_level);
 }
-
-
-// 우선순위가 높은 스레드가 본인의 우선순위를 기부해주는 함수
-// lock에 연결된 모든 스레드는 다 거쳐감 > waiting_lock 안에 있는 스레드들은 다 기부함수 실행
-// 기부는 8레벨까지 실행
-void donate_priority(void) {
-	int level;
-	struct thread *curr = thread_current();
-	for (level = 0; level < 8; level++) {
-		if (curr->waiting_lock != NULL) {
-			struct thread *waiting_highp_holder = curr->waiting_lock->holder; // 기다리고 있는 애 소환
-			// if (waiting_highp_holder->priority > curr->priority)
-				waiting_highp_holder->priority = curr->priority; // 기다리고 있는 애가 기부해줌
-				curr = waiting_highp_holder;
-		}
-	}
-}
-
-bool high_donation_priority(const struct list_elem *a, const struct list_elem *b,  void *aux UNUSED) {
-	return list_entry(a, struct thread, donation_elem)->priority > list_entry(b, struct thread, donation_elem)->priority;
-}
\ No newline at end of file
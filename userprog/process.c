@@ -13,6 +13,7 @@
 #include "threads/flags.h"
 #include "threads/init.h"
 #include "threads/interrupt.h"
+#include "threads/malloc.h"
 #include "threads/palloc.h"
 #include "threads/thread.h"
 #include "threads/mmu.h"
@@ -30,7 +31,7 @@ static void initd (void *f_name);
 static void __do_fork (void *);
 void argument_stack(char **argv, int argc, void **rsp);
 struct thread *get_child_process(int pid);
-static bool setup_stack (struct intr_frame *if_);
+static bool setup_stack (struct intr_frame *if_, size_t stack_limit);
 
 /*------project2 추가함수--------*/
 struct thread *get_child_process(int pid){
@@ -48,8 +49,40 @@ struct thread *get_child_process(int pid){
 	}
 	return NULL;
 }
+/* Grows T's file descriptor table to hold at least SIZE entries,
+   doubling it so that a process opening files one by one copies
+   its table only a logarithmic number of times.  Returns false if
+   SIZE is over FDCOUNT_LIMIT or memory is exhausted. */
+static bool
+fdt_grow (struct thread *t, int size) {
+	struct file **fdt;
+	int new_size = t->fdt_size;
+
+	if (size <= t->fdt_size)
+		return true;
+	if (size > FDCOUNT_LIMIT)
+		return false;
+	while (new_size < size)
+		new_size *= 2;
+	if (new_size > FDCOUNT_LIMIT)
+		new_size = FDCOUNT_LIMIT;
+
+	fdt = malloc (new_size * sizeof *fdt);
+	if (fdt == NULL)
+		return false;
+	memcpy (fdt, t->fdt, t->fdt_size * sizeof *fdt);
+	memset (fdt + t->fdt_size, 0, (new_size - t->fdt_size) * sizeof *fdt);
+	if (t->fdt != t->fdt_inline)
+		free (t->fdt);
+	t->fdt = fdt;
+	t->fdt_size = new_size;
+	return true;
+}
+
 struct file *process_get_file (int fd){
 	struct thread *curr = thread_current();
+	if (fd < 0 || fd >= curr->fdt_size)
+		return NULL;
 	/* 파일 디스크립터에 해당하는 파일 객체를 리턴 */
 	if(curr->fdt[fd] != NULL){
 		return curr->fdt[fd];
@@ -60,12 +93,12 @@ int process_add_file (struct file *f){
 /* 파일 객체를 파일 디스크립터 테이블에 추가*/
 	struct thread *curr = thread_current();
   //파일 디스크립터 테이블에서 비어있는 자리를 찾습니다.
-	while (curr->next_fd < FDCOUNT_LIMIT  && curr->fdt[curr->next_fd] != NULL) {
+	while (curr->next_fd < curr->fdt_size && curr->fdt[curr->next_fd] != NULL) {
 		curr->next_fd++;
 	}
 
-	// 파일 디스크립터 테이블이 꽉 찬 경우 에러를 반환
-	if (curr->next_fd >= FDCOUNT_LIMIT ) {
+	// 파일 디스크립터 테이블이 꽉 찬 경우 표를 키우고, 한도에 닿았으면 에러를 반환
+	if (!fdt_grow (curr, curr->next_fd + 1)) {
 		return -1;
 	}
 
@@ -76,8 +109,8 @@ int process_add_file (struct file *f){
 void process_close_file(int fd){
 	struct thread *curr = thread_current();
 	struct file **fdt = curr->fdt;
-	if (fd < 2 || fd >= FDCOUNT_LIMIT)
-		return NULL;
+	if (fd < 2 || fd >= curr->fdt_size)
+		return;
 	fdt[fd] = NULL;
 }
 
@@ -223,6 +256,15 @@ __do_fork (void *aux) {
 		goto error;
 
 	process_activate (current);
+
+	/* The child keeps its own handle on the executable, so that it
+	   can reload text after the parent exits. */
+	if (parent->running != NULL) {
+		current->running = file_reopen (parent->running);
+		if (current->running == NULL)
+			goto error;
+		file_deny_write (current->running);
+	}
 #ifdef VM
 	supplemental_page_table_init (&current->spt);
 	if (!supplemental_page_table_copy (&current->spt, &parent->spt))
@@ -240,11 +282,10 @@ __do_fork (void *aux) {
 	 * 힌트) 파일 객체를 복제하려면 include/filesys/file.h에서 `file_duplicate`를 사용합니다. 
 	 * 함수가 부모의 리소스를 성공적으로 복제할 때까지 부모는 fork()에서 반환하지 않아야 합니다.
 	 * */
-	if(parent->next_fd == FDCOUNT_LIMIT){
+	if (!fdt_grow (current, parent->fdt_size))
 		goto error;
-	}
 
-	for(int i = 0; i<FDCOUNT_LIMIT; i++){
+	for(int i = 0; i<parent->fdt_size; i++){
 		struct file *file = parent->fdt[i];
 		if(file == NULL)
 			continue;
@@ -305,9 +346,7 @@ process_exec (void *f_name) {
     #endif
 
 	/* And then load the binary */
-	lock_acquire(&filesys_lock);
 	success = load (file_name, &_if);
-	lock_release(&filesys_lock);
 
 	//hex_dump(_if.rsp, _if.rsp, USER_STACK - (uint64_t)_if.rsp, true);
 	/* If load failed, quit. */
@@ -392,11 +431,14 @@ process_exit (void) {
 	 * TODO: Implement process termination message (see
 	 * TODO: project2/process_termination.html).
 	 * TODO: We recommend you to implement process resource cleanup here. */ 
-	for (int i = 2; i < FDCOUNT_LIMIT; i++)
+	for (int i = 2; i < curr->fdt_size; i++)
 	{	if (curr->fdt[i] != NULL)
 			close(i);
 	}
-	palloc_free_multiple(curr->fdt, FDT_PAGES);		
+	if (curr->fdt != curr->fdt_inline)
+		free (curr->fdt);
+	curr->fdt = curr->fdt_inline;
+	curr->fdt_size = FDT_INLINE;
 	file_close(curr->running);
 
 	process_cleanup ();
@@ -518,6 +560,11 @@ load (const char *file_name, struct intr_frame *if_) {
 	off_t file_ofs;
 	bool success = false;
 	int i;
+#ifdef VM
+	size_t stack_limit = USER_STK_LIMIT;
+#else
+	size_t stack_limit = PGSIZE;
+#endif
 
 	/* Allocate and activate page directory. */
 	t->pml4 = pml4_create ();
@@ -558,10 +605,17 @@ load (const char *file_name, struct intr_frame *if_) {
 			goto done;
 		file_ofs += sizeof phdr;
 		switch (phdr.p_type) {
+			case PT_STACK:
+#ifdef VM
+				/* `ld -z stack-size=SIZE' asks for a stack of SIZE bytes. */
+				if (phdr.p_memsz > 0)
+					stack_limit = phdr.p_memsz < USER_STK_MAX
+						? ROUND_UP (phdr.p_memsz, PGSIZE) : USER_STK_MAX;
+				break;
+#endif
 			case PT_NULL:
 			case PT_NOTE:
 			case PT_PHDR:
-			case PT_STACK:
 			default:
 				/* Ignore this segment. */
 				break;
@@ -597,11 +651,13 @@ load (const char *file_name, struct intr_frame *if_) {
 				break;
 		}
 	}
+	/* 이전 이미지의 실행 파일은 이미 필요 없다. */
+	file_close (t->running);
 	t->running = file;	
 	file_deny_write(file);
 	
 	/* Set up stack. */
-	if (!setup_stack (if_))
+	if (!setup_stack (if_, stack_limit))
 		goto done;
 
 	/* Start address. */
@@ -729,7 +785,7 @@ load_segment(struct file *file, off_t ofs, uint8_t *upage,
 
 /* Create a minimal stack by mapping a zeroed page at the USER_STACK */
 static bool
-setup_stack (struct intr_frame *if_) {
+setup_stack (struct intr_frame *if_, size_t stack_limit UNUSED) {
 	uint8_t *kpage;
 	bool success = false;
 
@@ -790,10 +846,9 @@ lazy_load_segment (struct page *page, void *aux) {
 		return false;	
 
 	/* Load this page. */
-	if (file_read (file, kpage, page_read_bytes) != (int) page_read_bytes) {
-		palloc_free_page (kpage);
+	/* On failure the frame is released along with the page. */
+	if (file_read (file, kpage, page_read_bytes) != (int) page_read_bytes)
 		return false;
-	}
 	memset (kpage + page_read_bytes, 0, page_zero_bytes);
 	return true;
 }
@@ -827,6 +882,11 @@ load_segment (struct file *file, off_t ofs, uint8_t *upage,
 	ASSERT (pg_ofs (upage) == 0);
 	ASSERT (ofs % PGSIZE == 0);
 
+	if (spt_add_area (&thread_current ()->spt, upage,
+				upage + read_bytes + zero_bytes, VM_ANON, writable,
+				file, ofs) == NULL)
+		return false;
+
 	while (read_bytes > 0 || zero_bytes > 0) {
 		/* Do calculate how to fill this page.
 		 * We will read PAGE_READ_BYTES bytes from FILE
@@ -854,9 +914,10 @@ load_segment (struct file *file, off_t ofs, uint8_t *upage,
 	return true;
 }
 
-/* Create a PAGE of stack at the USER_STACK. Return true on success. */
+/* Create a PAGE of stack at the USER_STACK, in an area that lets the
+ * stack grow to STACK_LIMIT bytes. Return true on success. */
 static bool
-setup_stack (struct intr_frame *if_) {
+setup_stack (struct intr_frame *if_, size_t stack_limit) {
 	bool success = false;
 	void *stack_bottom = (void *) (((uint8_t *) USER_STACK) - PGSIZE);
 
@@ -865,6 +926,11 @@ setup_stack (struct intr_frame *if_) {
 	 * TODO: If success, set the rsp accordingly.
 	 * TODO: You should mark the page is stack. */
 	/* TODO: Your code goes here */
+	/* 스택이 자랄 수 있는 범위 전체를 영역으로 잡아 둔다. */
+	if (spt_add_area (&thread_current ()->spt,
+				(void *) (USER_STACK - stack_limit), (void *) USER_STACK,
+				VM_ANON, true, NULL, 0) == NULL)
+		return false;
 	if(vm_alloc_page(VM_ANON,stack_bottom,1)){ //stack_bottom에 스택 페이지를 할당
 		success = vm_claim_page(stack_bottom);
 		if(success){
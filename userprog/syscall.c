@@ -11,6 +11,7 @@
 #include <filesys/filesys.h>
 #include <filesys/file.h>
 #include <stdio.h>
+#include <string.h>
 #include "threads/palloc.h"
 #include "lib/kernel/stdio.h"
 #include "threads/synch.h"
@@ -44,6 +45,8 @@ void close (int fd);
 /*project3 추가*/
 void *mmap (void *addr, size_t length, int writable, int fd, off_t offset);
 void munmap (void *addr);
+int madvise (void *addr, size_t length, int advice);
+int msync (void *addr, size_t length);
 
 /*project4 추가*/
 bool chdir(const char *dir);
@@ -53,6 +56,8 @@ bool isdir(int fd);
 struct cluster_t *inumber(int fd);
 int symlink(const char* target, const char* linkpath);
 
+bool sched_stats (tid_t tid, struct sched_stats *stats);
+
 /* System call.
  *
  * Previously system call services was handled by the interrupt handler
@@ -77,7 +82,6 @@ syscall_init (void) {
 	 * mode stack. Therefore, we masked the FLAG_FL. */
 	write_msr(MSR_SYSCALL_MASK,
 			FLAG_IF | FLAG_TF | FLAG_DF | FLAG_IOPL | FLAG_AC | FLAG_NT);
-	lock_init(&filesys_lock);
 }
 
 /* The main system call interface */
@@ -137,6 +141,12 @@ syscall_handler (struct intr_frame *f UNUSED) {
 	case SYS_MUNMAP:
 		munmap (f->R.rdi);
 		break;
+	case SYS_MADVISE:
+		f->R.rax = madvise ((void *) f->R.rdi, f->R.rsi, f->R.rdx);
+		break;
+	case SYS_MSYNC:
+		f->R.rax = msync ((void *) f->R.rdi, f->R.rsi);
+		break;
 	case SYS_CHDIR:
 		f->R.rax = chdir(f->R.rdi);
 		break;
@@ -155,6 +165,9 @@ syscall_handler (struct intr_frame *f UNUSED) {
 	case SYS_SYMLINK:
 		f->R.rax = symlink(f->R.rdi, f->R.rsi);
 		break;
+	case SYS_SCHED_STATS:
+		f->R.rax = sched_stats(f->R.rdi, f->R.rsi);
+		break;
     // default:
     //     exit(-1);
     //     break;
@@ -203,10 +216,7 @@ int wait (tid_t pid){
 }
 bool create(const char *file, unsigned initial_size){
 	check_address(file);
-	lock_acquire(&filesys_lock);
-	bool success = filesys_create(file, initial_size);
-	lock_release(&filesys_lock);
-	return success;
+	return filesys_create(file, initial_size);
 }
 
 bool remove(const char *file){
@@ -219,16 +229,13 @@ int open (const char *file){
 /* 파일 디스크립터 리턴 */
 /* 해당 파일이 존재하지 않으면 -1 리턴 */
 	check_address(file);
-	lock_acquire(&filesys_lock);
 	struct file *fileobj = filesys_open(file);
 	if(fileobj == NULL){
-		lock_release(&filesys_lock);
 		return -1;
 	}
 	int fd = process_add_file(fileobj);
 	if(fd == -1) //fd table 꽉참
 		file_close(fileobj);
-	lock_release(&filesys_lock);
 	return fd;
 }
 
@@ -244,28 +251,23 @@ int filesize (int fd){
 int read (int fd, void *buffer, unsigned size) {
 	check_address(buffer);
 
-	lock_acquire(&filesys_lock);
 	if(fd == 1){
-		lock_release(&filesys_lock);
 		return -1;
 	}
 
 	if(fd == 0){
 		input_getc();
-		lock_release(&filesys_lock);
 		return size;
 	}
   	struct file *fileobj= process_get_file(fd);
 	if(fileobj){
 		struct page *page = spt_find_page(&thread_current()->spt,buffer);
 		if(page != NULL && page->writable == 0){
-			lock_release(&filesys_lock);
 			exit(-1);
 		}
 	}
 		
 	size = file_read(fileobj,buffer,size);
-	lock_release(&filesys_lock);	
 	return size;
 }
 
@@ -273,21 +275,17 @@ int write (int fd, const void *buffer, unsigned size) {
 
 	check_address(buffer);
 
-	lock_acquire(&filesys_lock);
 	if(fd == 1){
 		 putbuf(buffer, size);  //문자열을 화면에 출력해주는 함수
 		//putbuf(): 버퍼 안에 들어있는 값 중 사이즈 N만큼을 console로 출력
-		lock_release(&filesys_lock);
 		return size;
 	}
 	struct file *fileobj= process_get_file(fd);
 	if(fileobj == NULL){
-		lock_release(&filesys_lock);
 		return -1;
 	}
 	
 	size = file_write(fileobj,buffer,size);
-	lock_release(&filesys_lock);
 	return size;
 }
 
@@ -351,15 +349,26 @@ void *mmap(void *addr, size_t length, int writable, int fd, off_t offset)
 	if(length == 0 || KERN_BASE <= length || addr == NULL || is_kernel_vaddr(addr) || pg_round_down(addr) != addr){
 		return NULL;
 	}
-	if (spt_find_page(&thread_current()->spt, addr)) {
-        return NULL;
-	}
 	return do_mmap(addr, length, writable, fileobj, offset);
 }
 void munmap (void *addr){
 	do_munmap(addr);
 }
 
+/* Passes ADVICE about [ADDR, ADDR + LENGTH) on to the VM.
+   Returns 0 on success, -1 if ADDR is not page-aligned, the
+   advice is unknown or part of the range is not mapped. */
+int madvise (void *addr, size_t length, int advice){
+	return vm_madvise(addr, length, advice) ? 0 : -1;
+}
+
+/* Writes the dirty mapped pages in [ADDR, ADDR + LENGTH) back to
+   their files.  Returns 0 on success, -1 if ADDR is not
+   page-aligned or part of the range is not mapped. */
+int msync (void *addr, size_t length){
+	return vm_msync(addr, length) ? 0 : -1;
+}
+
 bool chdir(const char *dir){
 	if(dir == NULL)
 		return false;
@@ -413,10 +422,7 @@ bool chdir(const char *dir){
 }
 //디렉토리 생성, 기존에 존재하는 이름은 생성X
 bool mkdir (const char *dir){
-	lock_acquire(&filesys_lock); // 이거 맞는지....?
-	bool new_dir = filesys_create_dir(dir); // filesys_create_dir() 함수 없는뎅
-	lock_release(&filesys_lock);
-	return new_dir;
+	return filesys_create_dir(dir);
 }
 
 //디렉토리 내 파일 존재 여부 확인
@@ -489,6 +495,22 @@ int symlink(const char* target, const char* linkpath){
 	return success -1;
 }
 
+/* Copies the scheduler statistics of thread TID, or of the
+   calling thread if TID is 0, into STATS.  Returns false if no
+   such thread is alive. */
+bool sched_stats (tid_t tid, struct sched_stats *stats){
+	struct sched_stats kstats;
+
+	check_address(stats);
+	check_address((uint8_t *) stats + sizeof *stats - 1);
+
+	if (tid == 0)
+		tid = thread_tid();
+	if (!thread_get_sched_stats(tid, &kstats))
+		return false;
+	memcpy(stats, &kstats, sizeof kstats);
+	return true;
+}
 
 void check_address(void *addr){
 	struct thread *curr = thread_current();
@@ -6,6 +6,10 @@
 #include "lib/kernel/bitmap.h"
 #include "include/lib/string.h"
 #include "include/threads/mmu.h"
+#include "threads/synch.h"
+#include "threads/malloc.h"
+#include "lib/kernel/compress.h"
+#include "userprog/process.h"
 
 /* DO NOT MODIFY BELOW LINE */
 static struct disk *swap_disk;
@@ -15,6 +19,30 @@ static void anon_destroy (struct page *page);
 
 /*project3 추가*/
 struct bitmap *swap_table;
+static struct lock swap_lock;   /* Protects swap_table and swap_hint. */
+static size_t swap_hint;        /* Where the next slot search starts. */
+
+/* Compressed swap cache.
+   An evicted anonymous page is first compressed into a malloc'd
+   zswap_entry, taken from the kernel pool, and only goes to the
+   swap disk if it does not compress to half a page.  Once the
+   cache holds more than ZSWAP_POOL_MAX compressed bytes, the
+   entries evicted longest ago are written back to the swap disk. */
+struct zswap_entry {
+	struct list_elem lru_elem;  /* In zswap_lru, oldest first. */
+	struct page *page;          /* Page whose contents these are. */
+	size_t size;                /* Bytes in DATA. */
+	uint8_t data[];             /* Compressed contents. */
+};
+
+#define ZSWAP_ENTRY_MAX (PGSIZE / 2)
+#define ZSWAP_POOL_MAX (256 * PGSIZE)
+
+static struct list zswap_lru;
+static size_t zswap_bytes;      /* Total size of all entries' DATA. */
+static uint8_t *zswap_buf;      /* Scratch page. */
+static struct lock zswap_lock;  /* Protects all of the above and
+                                   every page's anon.zentry. */
 const size_t SECTORS_PER_PAGE = PGSIZE/DISK_SECTOR_SIZE; //8
 
 
@@ -35,12 +63,26 @@ vm_anon_init (void) {
 	swap_disk = disk_get(1,1); //swap_disk를 swap 공간으로 사용하겠다.
 	size_t swap_size = disk_size(swap_disk) / SECTORS_PER_PAGE; //스왑공간의 페이지 수 계산
 	swap_table = bitmap_create(swap_size); //스왑공간의 각페이지에 대한 상태를 추적
+	lock_init(&swap_lock); //page-out 데몬과 page fault가 동시에 스왑할 수 있음
+
+	list_init(&zswap_lru);
+	zswap_bytes = 0;
+	zswap_buf = palloc_get_page(PAL_ASSERT);
+	lock_init(&zswap_lock);
 }
 
 /* Initialize the file mapping */
 bool
 anon_initializer (struct page *page, enum vm_type type, void *kva) {
 	struct uninit_page *uninit = &page->uninit;// ANON page를 초기화하기 위해 해당 데이터를 0으로 초기화해줌
+	struct lazy_load_info *segment = NULL;
+
+	/* A writable page of an executable segment is a private copy of
+	   the file.  Remember where it came from before the uninit page
+	   is cleared. */
+	if (VM_TYPE(page->operations->type) == VM_UNINIT
+			&& uninit->init == lazy_load_segment && page->writable)
+		segment = uninit->aux;
 	memset(uninit,0,sizeof(struct uninit_page));
 	
 	/* Set up the handler */
@@ -49,6 +91,10 @@ anon_initializer (struct page *page, enum vm_type type, void *kva) {
 	//해당 페이지는 물리 메모리 위에 있으므로 swap_index의 값을 -1로 설정
 	struct anon_page *anon_page = &page->anon;
 	anon_page->swap_index = -1; //해당 페이지가 스왑공간에는 저장되어 있지 않음
+	anon_page->zentry = NULL;
+	anon_page->text = NULL;
+	anon_page->segment = segment;
+	anon_page->lazy_free = false;
 
 	return true;
 }
@@ -125,50 +171,274 @@ anon_initializer (struct page *page, enum vm_type type, void *kva) {
 // }
 
 /*내꺼*/
+/* Allocates CNT consecutive swap slots and returns the first, or
+   BITMAP_ERROR.  Next fit: the search starts where the previous
+   allocation ended, so slots handed out together or one after
+   another stay together on disk. */
+static size_t
+swap_slot_alloc (size_t cnt) {
+    lock_acquire(&swap_lock);
+    size_t slot = bitmap_scan_and_flip(swap_table, swap_hint, cnt, false);
+    if (slot == BITMAP_ERROR && swap_hint != 0)
+        slot = bitmap_scan_and_flip(swap_table, 0, cnt, false);
+    if (slot != BITMAP_ERROR)
+        swap_hint = (slot + cnt) % bitmap_size(swap_table);
+    lock_release(&swap_lock);
+    return slot;
+}
+
+/* Frees swap slot SLOT. */
+static void
+swap_slot_free (size_t slot) {
+    lock_acquire(&swap_lock);
+    ASSERT (bitmap_test(swap_table, slot));
+    bitmap_set(swap_table, slot, false);
+    lock_release(&swap_lock);
+}
+
+/* Writes the CNT pages in PAGES, which must be in frames, to the
+   swap slots starting at SLOT with one disk request, and unmaps
+   them from their owners' pml4s. */
+static void
+swap_write (struct page **pages, size_t cnt, size_t slot) {
+    struct disk_iov iov[SWAP_CLUSTER_MAX];
+
+    ASSERT (cnt >= 1 && cnt <= SWAP_CLUSTER_MAX);
+    for (size_t i = 0; i < cnt; i++)
+        iov[i] = (struct disk_iov) { pages[i]->frame->kva, SECTORS_PER_PAGE };
+    disk_writev(swap_disk, slot * SECTORS_PER_PAGE, iov, cnt);
+
+    for (size_t i = 0; i < cnt; i++) {
+        // 쫓겨나는 페이지는 현재 스레드가 아닌 페이지 owner의 pml4에 매핑되어 있다.
+        pml4_clear_page(pages[i]->owner->pml4, pages[i]->va);
+        // page의 swap_index 값을 이 page가 저장된 swap slot의 번호로 써준다.
+        pages[i]->anon.swap_index = slot + i;
+    }
+}
+
+/* Writes back the oldest entry in the compressed swap cache to
+   the swap disk.  Returns false if the cache is empty or the swap
+   disk is full.  The caller must hold zswap_lock. */
 static bool
-anon_swap_in (struct page *page, void *kva) {
-	struct anon_page *anon_page = &page->anon;
+zswap_writeback (void) {
+    struct zswap_entry *e;
+    struct disk_iov iov = { zswap_buf, SECTORS_PER_PAGE };
+    size_t slot;
 
-	int page_no = anon_page->swap_index;
+    ASSERT (lock_held_by_current_thread(&zswap_lock));
 
-    if(bitmap_test(swap_table, page_no) == false){
+    if (list_empty(&zswap_lru) || (slot = swap_slot_alloc(1)) == BITMAP_ERROR)
+        return false;
+    e = list_entry(list_pop_front(&zswap_lru), struct zswap_entry, lru_elem);
+    decompress_words(e->data, e->size, zswap_buf, PGSIZE);
+    disk_writev(swap_disk, slot * SECTORS_PER_PAGE, &iov, 1);
+
+    e->page->anon.swap_index = slot;
+    e->page->anon.zentry = NULL;
+    zswap_bytes -= e->size;
+    free(e);
+    return true;
+}
+
+/* Compresses PAGE, which must be in a frame, into the compressed
+   swap cache and unmaps it from its owner's pml4.  Returns false,
+   leaving PAGE alone, if it does not compress well enough. */
+static bool
+zswap_store (struct page *page) {
+    struct zswap_entry *e = NULL;
+    size_t size;
+
+    lock_acquire(&zswap_lock);
+    size = compress_words(page->frame->kva, PGSIZE, zswap_buf,
+            ZSWAP_ENTRY_MAX - sizeof *e);
+    if (size != 0)
+        e = malloc(sizeof *e + size);
+    if (e == NULL) {
+        lock_release(&zswap_lock);
         return false;
     }
-    // 해당 swap 영역의 data를 가상 주소공간 kva에 써준다.
-    for(int i=0; i< SECTORS_PER_PAGE; ++i){
-        disk_read(swap_disk, (page_no * SECTORS_PER_PAGE) + i, kva + (DISK_SECTOR_SIZE * i));
+    e->page = page;
+    e->size = size;
+    memcpy(e->data, zswap_buf, size);
+    list_push_back(&zswap_lru, &e->lru_elem);
+    zswap_bytes += size;
+    page->anon.zentry = e;
+    pml4_clear_page(page->owner->pml4, page->va);
+
+    while (zswap_bytes > ZSWAP_POOL_MAX && zswap_writeback())
+        continue;
+    lock_release(&zswap_lock);
+    return true;
+}
+
+/* If PAGE is in the compressed swap cache, decompresses it into KVA,
+   drops it from the cache and returns true.  Otherwise returns
+   false. */
+static bool
+zswap_load (struct page *page, void *kva) {
+    struct zswap_entry *e;
+
+    lock_acquire(&zswap_lock);
+    e = page->anon.zentry;
+    if (e != NULL) {
+        decompress_words(e->data, e->size, kva, PGSIZE);
+        list_remove(&e->lru_elem);
+        zswap_bytes -= e->size;
+        page->anon.zentry = NULL;
+        free(e);
     }
-    // 해당 swap slot false로 만들어줌(다음번에 쓸 수 있게)
-    bitmap_set(swap_table, page_no, false);
+    lock_release(&zswap_lock);
+    return e != NULL;
+}
+
+static bool
+anon_swap_in (struct page *page, void *kva) {
+    ASSERT (page->frame != NULL && page->frame->kva == kva);
+
+    // 압축 캐시에 있으면 디스크를 읽지 않고 압축만 푼다.
+    if (zswap_load(page, kva))
+        return true;
+    if (page->anon.swap_index != -1) {
+        anon_swap_in_cluster(&page, 1);
+        return true;
+    }
+    // 실행 파일의 페이지는 파일에서 다시 읽는다. 쓰기 가능한 데이터
+    // 페이지는 MADV_DONTNEED로 버려졌을 때만 여기까지 온다.
+    struct lazy_load_info *text = page->anon.text != NULL
+        ? page->anon.text : page->anon.segment;
+    if (text == NULL) {
+        // 버려진 익명 페이지(MADV_DONTNEED, MADV_FREE)는 0으로 채운다.
+        memset(kva, 0, PGSIZE);
+        return true;
+    }
+    if (file_read_at(text->file, kva, text->page_read_bytes, text->ofs)
+            != (off_t) text->page_read_bytes)
+        return false;
+    memset(kva + text->page_read_bytes, 0, PGSIZE - text->page_read_bytes);
     return true;
 }
 
+/* Unmaps PAGE and returns true if its contents need not be saved:
+   executable text, which is always clean, or a page given
+   MADV_FREE and not written since.  Otherwise returns false. */
+static bool
+anon_drop (struct page *page) {
+    uint64_t *pml4 = page->owner->pml4;
+
+    if (page->anon.lazy_free) {
+        page->anon.lazy_free = false;
+        if (!pml4_is_dirty(pml4, page->va)) {
+            pml4_clear_page(pml4, page->va);
+            return true;
+        }
+    }
+    // 실행 파일 페이지는 항상 깨끗하므로 매핑만 지우면 된다.
+    if (page->anon.text != NULL) {
+        pml4_clear_page(pml4, page->va);
+        return true;
+    }
+    return false;
+}
+
 /* Swap out the page by writing contents to the swap disk. */
 static bool
 anon_swap_out (struct page *page) {
-	struct anon_page *anon_page = &page->anon;
-	int page_no = bitmap_scan_and_flip(swap_table, 0, 1, false);
-    if(page_no == BITMAP_ERROR){
+    if (anon_drop(page))
+        return true;
+    if (zswap_store(page))
+        return true;
+
+    size_t slot = swap_slot_alloc(1);
+    if (slot == BITMAP_ERROR)
         return false;
+    swap_write(&page, 1, slot);
+    return true;
+}
+
+/* Swaps out the CNT anonymous pages in PAGES, at most
+   SWAP_CLUSTER_MAX.  Pages that need no saving are just unmapped.
+   Pages that compress well go to the compressed swap cache.  The
+   rest go to the swap disk as one cluster of consecutive swap slots
+   written with a single disk request, or a page at a time if no
+   run of free slots is long enough.  Returns false if swap space
+   runs out. */
+bool
+anon_swap_out_cluster (struct page **pages, size_t cnt) {
+    struct page *rest[SWAP_CLUSTER_MAX];
+    size_t rest_cnt = 0;
+    size_t slot;
+
+    ASSERT (cnt <= SWAP_CLUSTER_MAX);
+    for (size_t i = 0; i < cnt; i++) {
+        if (!anon_drop(pages[i]) && !zswap_store(pages[i]))
+            rest[rest_cnt++] = pages[i];
     }
-    // 한 page를 disk에 쓰기 위해 SECTORS_PER_PAGE개의 섹터에 저장한다.
-    // 이 때 disk의 각 섹터의 크기(DISK_SECTOR_SIZE)만큼 써 준다.
-    for(int i=0; i<SECTORS_PER_PAGE; ++i){
-        disk_write(swap_disk, (page_no * SECTORS_PER_PAGE) + i, page->va + (DISK_SECTOR_SIZE * i));
+    if (rest_cnt == 0)
+        return true;
+
+    slot = swap_slot_alloc(rest_cnt);
+    if (slot != BITMAP_ERROR) {
+        swap_write(rest, rest_cnt, slot);
+        return true;
+    }
+    for (size_t i = 0; i < rest_cnt; i++) {
+        slot = swap_slot_alloc(1);
+        if (slot == BITMAP_ERROR)
+            return false;
+        swap_write(&rest[i], 1, slot);
     }
-    // swap table의 해당 page에 대한 swap slot의 bit를 ture로 바꿔준다.
-    // 해당 page의 pte에서 present bit을 0으로 바꿔준다.
-    // 이제 프로세스가 이 page에 접근하면 page fault가 뜬다.
-    
-    pml4_clear_page(thread_current()->pml4, page->va);
-    // page의 swap_index 값을 이 page가 저장된 swap slot의 번호로 써준다.
-    anon_page->swap_index = page_no;
-    
     return true;
 }
 
+/* Swaps in the CNT anonymous pages in PAGES, at most
+   SWAP_CLUSTER_MAX, whose swap slots must be consecutive, into
+   their frames with a single disk request, and frees the slots. */
+void
+anon_swap_in_cluster (struct page **pages, size_t cnt) {
+    struct disk_iov iov[SWAP_CLUSTER_MAX];
+    size_t slot = pages[0]->anon.swap_index;
+
+    ASSERT (cnt >= 1 && cnt <= SWAP_CLUSTER_MAX);
+    for (size_t i = 0; i < cnt; i++) {
+        ASSERT (pages[i]->anon.swap_index == (int) (slot + i));
+        iov[i] = (struct disk_iov) { pages[i]->frame->kva, SECTORS_PER_PAGE };
+    }
+    // 해당 swap 영역의 data를 frame에 한 번에 읽어온다.
+    disk_readv(swap_disk, slot * SECTORS_PER_PAGE, iov, cnt);
+
+    // 해당 swap slot false로 만들어줌(다음번에 쓸 수 있게)
+    for (size_t i = 0; i < cnt; i++) {
+        swap_slot_free(slot + i);
+        pages[i]->anon.swap_index = -1;
+    }
+}
+
 /* Destroy the anonymous page. PAGE will be freed by the caller. */
 static void
 anon_destroy (struct page *page) {
+    vm_free_frame(page);
+    anon_discard(page);
+}
+
+/* Frees whatever PAGE has saved in the compressed swap cache or
+   on the swap disk.  Unless it belongs to an executable segment,
+   PAGE then reads back as zeros the next time it is swapped in. */
+void
+anon_discard (struct page *page) {
     struct anon_page *anon_page = &page->anon;
+
+    lock_acquire(&zswap_lock);
+    if (anon_page->zentry != NULL) {
+        struct zswap_entry *e = anon_page->zentry;
+
+        list_remove(&e->lru_elem);
+        zswap_bytes -= e->size;
+        anon_page->zentry = NULL;
+        free(e);
+    }
+    lock_release(&zswap_lock);
+    if (anon_page->swap_index != -1) {
+        swap_slot_free(anon_page->swap_index);
+        anon_page->swap_index = -1;
+    }
 }
\ No newline at end of file
@@ -4,6 +4,9 @@
 #include "include/threads/vaddr.h"
 #include "userprog/process.h"
 #include "include/threads/mmu.h"
+#include "filesys/inode.h"
+#include "threads/malloc.h"
+#include <stdlib.h>
 
 static bool file_backed_swap_in (struct page *page, void *kva);
 static bool file_backed_swap_out (struct page *page);
@@ -33,6 +36,7 @@ file_backed_initializer (struct page *page, enum vm_type type, void *kva) {
 	file_page->file = arg->file;
 	file_page->file_ofs = arg->ofs;
 	file_page->read_bytes = arg->page_read_bytes;
+	return true;
 }
 
 /* Swap in the page by read contents from the file. */
@@ -63,14 +67,16 @@ file_backed_swap_out (struct page *page) {
 
 	if (page == NULL)
 		return false;
-	
-	if (pml4_is_dirty(thread_current()->pml4, page->va)) {
-		file_write_at(file_page->file, page->va, file_page->read_bytes, file_page->file_ofs);
-		pml4_set_dirty(thread_current()->pml4, page->va, 0);
+
+	/* The page belongs to its owner, not necessarily to us. */
+	struct frame *frame = page->frame;
+	uint64_t *pml4 = page->owner->pml4;
+
+	if (pml4_is_dirty(pml4, page->va)) {
+		file_write_at(file_page->file, frame->kva, file_page->read_bytes, file_page->file_ofs);
+		pml4_set_dirty(pml4, page->va, 0);
 	}
-	// page->frame->page = NULL;
-	page->frame = NULL;
-	pml4_clear_page(thread_current()->pml4, page->va);
+	pml4_clear_page(pml4, page->va);
 	return true;
 }
 
@@ -79,13 +85,50 @@ static void
 file_backed_destroy (struct page *page) {
 	struct supplemental_page_table *spt = &thread_current()->spt;
 	struct file_page *arg = &page->file;
-		if (pml4_is_dirty(thread_current()->pml4, page->va)){
+		if (page->frame != NULL && pml4_is_dirty(thread_current()->pml4, page->va)){
 			/* 어떤 offset부터 썼는지 확인 후 그 offset부터 write */
-			file_write_at(arg->file, page->va, arg->read_bytes, arg->file_ofs);
+			file_write_at(arg->file, page->frame->kva, arg->read_bytes, arg->file_ofs);
 			/* dirty bit 0으로 set */
 			pml4_set_dirty(thread_current()->pml4, page->va, 0);
 		}
-	pml4_clear_page(thread_current()->pml4, page->va);
+	vm_free_frame(page);
+}
+
+/* Orders writeback entries by inode, then offset. */
+static int
+file_wb_compare (const void *a_, const void *b_) {
+	const struct file_wb *a = a_;
+	const struct file_wb *b = b_;
+
+	if (a->inode != b->inode)
+		return a->inode < b->inode ? -1 : 1;
+	return a->ofs < b->ofs ? -1 : a->ofs > b->ofs;
+}
+
+/* Writes the CNT queued pages in WB, at most FILE_WB_BATCH, back to
+ * their files.  They are sorted by file and offset first, and each
+ * run of pages that are adjacent in the same file goes out with one
+ * inode_write_pages(). */
+void
+file_backed_writeback (struct file_wb *wb, size_t cnt) {
+	void *pages[FILE_WB_BATCH];
+	size_t i, j;
+
+	ASSERT (cnt <= FILE_WB_BATCH);
+
+	qsort (wb, cnt, sizeof *wb, file_wb_compare);
+	for (i = 0; i < cnt; i = j) {
+		off_t size = wb[i].len;
+
+		pages[0] = wb[i].frame->kva;
+		for (j = i + 1; j < cnt && wb[j].inode == wb[i].inode
+				&& wb[j - 1].len == PGSIZE
+				&& wb[j].ofs == wb[j - 1].ofs + PGSIZE; j++) {
+			pages[j - i] = wb[j].frame->kva;
+			size += wb[j].len;
+		}
+		inode_write_pages (wb[i].inode, pages, size, wb[i].ofs);
+	}
 }
 
 /* Do the mmap */
@@ -98,7 +141,15 @@ do_mmap (void *addr, size_t length, int writable,
 	size_t read_bytes = length < file_length(reopen_file) ? length:file_length(reopen_file);
 	size_t zero_bytes = read_bytes%PGSIZE ==0 ? 0 : PGSIZE-(read_bytes%PGSIZE);
 	void * start_addr = addr;
-	
+
+	/* 이미 다른 영역과 겹치면 실패 */
+	if (spt_add_area (&thread_current ()->spt, addr,
+				addr + read_bytes + zero_bytes, VM_FILE, writable,
+				reopen_file, offset) == NULL) {
+		file_close (reopen_file);
+		return NULL;
+	}
+
 	while (read_bytes>0 || zero_bytes > 0)
 	{
 		size_t tmp_read_bytes = read_bytes <PGSIZE ? read_bytes:PGSIZE;
@@ -112,11 +163,11 @@ do_mmap (void *addr, size_t length, int writable,
 		aux->page_zero_bytes = tmp_zero_bytes;
 
 		if(!vm_alloc_page_with_initializer(VM_FILE,addr,writable,lazy_load_segment,aux)){
+			free(aux);
+			do_munmap(start_addr);
 			return NULL;
 		}
-		struct page *p = spt_find_page(&thread_current()->spt, addr);
-		p->page_cnt = read_bytes / PGSIZE + 1;
-		
+
 		read_bytes -= tmp_read_bytes;
 		zero_bytes -= tmp_zero_bytes;
 		addr += PGSIZE;
@@ -129,23 +180,35 @@ do_mmap (void *addr, size_t length, int writable,
 /* Do the munmap */
 void
 do_munmap (void *addr) {
-	// page의 전체 길이 -> spt_find_page로 해당 addr를 찾아 그 페이지 구조체의 길이 얻어오기
-	struct page *page = spt_find_page(&thread_current()->spt, addr);
-	off_t page_cnt = page->page_cnt;
-	/* 변경된 파일은 쓴 후, dirty bit 원래대로 돌려주기
-	spt 테이블에서 삭제하고 pml4 테이블에서 삭제*/
-	for (int i = 0; i < page_cnt; i++)
-	{
+	struct supplemental_page_table *spt = &thread_current ()->spt;
+	struct vm_area *area = spt_find_area (spt, addr);
+	struct file *file;
+	struct list_elem *e;
+	void *end;
+
+	/* ADDR는 매핑의 첫 주소여야 한다. */
+	if (area == NULL || area->type != VM_FILE || area->start != addr)
+		return;
+	e = list_prev (&area->elem);
+	if (e != list_head (&spt->areas)) {
+		struct vm_area *prev = list_entry (e, struct vm_area, elem);
+		if (prev->file == area->file && prev->end == addr)
+			return;
+	}
 
-		addr += PGSIZE;
-		if (page)
-		{
-			/* spt_remove_page -> vm_dealloc_page -> destroy(file_destroy)순으로 호출 */
-			//spt_remove_page(&thread_current()->spt, page);//-> 이거 하면 안됨	
-			//hash_delete(&thread_current()->spt.pages, &page->hash_elem);
-			destroy(page);
-			//free(page);//-> 이것도 하면 안됨	
-		}
-		page = spt_find_page(&thread_current()->spt, addr);
+	/* madvise()가 쪼개 놓은 조각까지 매핑 전체의 끝을 찾는다. */
+	file = area->file;
+	end = area->end;
+	for (e = list_next (&area->elem); e != list_end (&spt->areas);
+			e = list_next (e)) {
+		struct vm_area *next = list_entry (e, struct vm_area, elem);
+		if (next->file != file || next->start != end)
+			break;
+		end = next->end;
 	}
-}
\ No newline at end of file
+
+	/* 더티 페이지를 파일 순서대로 한꺼번에 써 두고, 범위를 한 번에 걷어 낸다. */
+	vm_writeback (spt, addr, end);
+	spt_remove_range (spt, addr, end);
+	file_close (file);
+}
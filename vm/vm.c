@@ -1,5 +1,7 @@
 /* vm.c: Generic interface for virtual memory objects. */
 
+#include <stdio.h>
+#include <string.h>
 #include "threads/malloc.h"
 #include "vm/vm.h"
 #include "vm/inspect.h"
@@ -7,10 +9,110 @@
 #include "userprog/process.h"
 #include "include/threads/vaddr.h"
 #include "include/threads/mmu.h"
+#include "threads/synch.h"
+#include "devices/timer.h"
+#include <madvise.h>
+#include "filesys/inode.h"
 
 
-#define USER_STK_LIMIT (1 << 20)
-struct list frame_table;
+/* Supplemental page table radix tree.  A user page number has
+   fewer than SPT_BITS * SPT_LEVELS bits, since user addresses lie
+   below KERN_BASE; each level of the tree consumes SPT_BITS of
+   it, most significant first.  Leaf slots point to struct page. */
+#define SPT_BITS 7
+#define SPT_FANOUT (1 << SPT_BITS)
+#define SPT_LEVELS 4
+
+struct spt_node {
+	void *slot[SPT_FANOUT];     /* Child nodes, or pages at level 0. */
+};
+
+typedef bool spt_action_func (struct page *, void *aux);
+static void **spt_slot (struct supplemental_page_table *, const void *va,
+		bool create);
+static bool spt_walk_range (struct supplemental_page_table *, void *start,
+		void *end, spt_action_func *, void *aux, bool unlink);
+static bool spt_copy_page (struct page *, void *dst);
+
+/* Frame table: one entry per user pool page, indexed by
+   palloc_user_page_idx().  FRAME_LOCK protects every entry and the
+   clock hand, which sweeps the table for eviction and keeps its
+   place between evictions. */
+static struct frame *frame_table;
+static size_t frame_cnt;
+static size_t clock_hand;
+static struct lock frame_lock;
+
+/* Signaled, with FRAME_LOCK, whenever an eviction finishes. */
+static struct condition evict_cond;
+
+/* Page-out daemon.  It is woken when fewer than FREE_LOW frames are
+   free in the user pool and evicts pages, PAGEOUT_BATCH frames at a
+   time, until FREE_HIGH frames are free, so that page faults rarely
+   have to evict for themselves.  FREE_CNT is protected by
+   FRAME_LOCK. */
+#define PAGEOUT_BATCH 16
+
+/* Most pages one swap-in fault brings back, counting the faulting
+   page. */
+#define SWAP_READAHEAD 8
+
+/* Fewest and most pages one fault on a file-backed page reads in,
+   counting the faulting page.  See vm_fault_around(). */
+#define FAULT_AROUND_MIN 4
+#define FAULT_AROUND_MAX 32
+static size_t free_cnt;
+static size_t free_low, free_high;
+
+/* Pages each stack growth fault adds.  Set with -sg. */
+size_t stack_grow_pages = STACK_GROW_PAGES;
+
+/* Statistics. */
+static long long stack_fault_cnt;   /* # of faults that grew a stack. */
+static long long stack_page_cnt;    /* # of stack pages they added. */
+static struct semaphore pageout_sema;
+static bool pageout_kicked;
+
+static void pageout_daemon (void *aux);
+static struct frame *vm_get_frame (void);
+static void frame_release (struct frame *frame);
+
+/* Same-page merging daemon.  Every KSM_SLEEP ticks it hashes the
+   contents of the next KSM_SCAN_BATCH frames, and merges frames of
+   anonymous pages that turn out to be identical into one frame
+   shared copy-on-write.  KSM_TABLE, protected by FRAME_LOCK, maps a
+   contents hash to one frame with that hash. */
+#define KSM_SCAN_BATCH 64
+#define KSM_SLEEP (TIMER_FREQ / 10)
+static struct hash ksm_table;
+static size_t ksm_hand;
+
+static void ksm_daemon (void *aux);
+static uint64_t ksm_hash (const struct hash_elem *e, void *aux);
+static bool ksm_less (const struct hash_elem *a, const struct hash_elem *b,
+		void *aux);
+
+/* Shared executable text.  TEXT_TABLE, protected by FRAME_LOCK,
+   maps the file range a read-only executable page is loaded from
+   to a frame holding it, so that every process running the same
+   executable shares one frame per text page. */
+static struct hash text_table;
+
+static uint64_t text_hash (const struct hash_elem *e, void *aux);
+static bool text_less (const struct hash_elem *a, const struct hash_elem *b,
+		void *aux);
+
+/* Flusher daemon.  Every FLUSH_INTERVAL ticks it writes back the
+   dirty file-backed pages of every process, FILE_WB_BATCH at a
+   time, so that little is lost in a crash and munmap() and exit
+   find little left to write. */
+#define FLUSH_INTERVAL TIMER_FREQ
+
+static void flush_daemon (void *aux);
+
+/* A frame of zeros, pinned for good, that untouched anonymous pages
+   share read-only until they are first written. */
+static struct frame *zero_frame;
 
 /* Initializes the virtual memory subsystem by invoking each subsystem's
  * intialize codes. */
@@ -24,7 +126,39 @@ void vm_init(void)
 	register_inspect_intr();
 	/* DO NOT MODIFY UPPER LINES. */
 	/* TODO: Your code goes here. */
-	list_init(&frame_table);
+	frame_cnt = palloc_user_page_cnt ();
+	frame_table = calloc (frame_cnt, sizeof *frame_table);
+	if (frame_table == NULL)
+		PANIC ("vm_init: cannot allocate frame table");
+	for (size_t i = 0; i < frame_cnt; i++)
+		list_init (&frame_table[i].pages);
+	clock_hand = 0;
+	lock_init (&frame_lock);
+	cond_init (&evict_cond);
+
+	free_cnt = palloc_user_free_cnt ();
+	free_low = free_cnt / 32 + 1;
+	free_high = 2 * free_low;
+	sema_init (&pageout_sema, 0);
+	pageout_kicked = false;
+	thread_create ("pageout", PRI_DEFAULT, pageout_daemon, NULL);
+
+	/* vm_get_frame() leaves it pinned. */
+	zero_frame = vm_get_frame ();
+	memset (zero_frame->kva, 0, PGSIZE);
+
+	/* Zero-filled frames found by the merging daemon join the zero
+	   frame. */
+	hash_init (&ksm_table, ksm_hash, ksm_less, NULL);
+	ksm_hand = 0;
+	zero_frame->ksm_hash = hash_bytes (zero_frame->kva, PGSIZE);
+	zero_frame->ksm_listed = true;
+	hash_insert (&ksm_table, &zero_frame->ksm_elem);
+	thread_create ("ksm", PRI_MIN, ksm_daemon, NULL);
+
+	hash_init (&text_table, text_hash, text_less, NULL);
+
+	thread_create ("flush", PRI_DEFAULT, flush_daemon, NULL);
 }
 
 /* Get the type of the page. This function is useful if you want to know the
@@ -80,6 +214,10 @@ bool vm_alloc_page_with_initializer(enum vm_type type, void *upage, bool writabl
 		}
 		// TODO: should modify the field after calling the uninit_new.
 		new_page->writable = writable;
+		new_page->owner = thread_current ();
+		struct vm_area *area = spt_find_area (spt, upage);
+		new_page->drop_behind = area != NULL
+			&& area->advice == MADV_SEQUENTIAL;
 		/* TODO: Insert the page into the spt. */
 		return spt_insert_page(spt, new_page);
 	}
@@ -92,68 +230,545 @@ err:
 struct page *
 spt_find_page(struct supplemental_page_table *spt UNUSED, void *va UNUSED)
 {
-	struct page *page = NULL;
-	page = (struct page *)malloc(sizeof(struct page));
-	/* TODO: Fill this function. */
-	struct hash_elem *e;
-	page->va = pg_round_down(va);
-	e = hash_find (&spt->pages, &page->hash_elem);
-	free(page); //추가!!!!!!!!!!!!!!!!!!!!!!!!!!!
-	return e != NULL ? hash_entry (e, struct page, hash_elem) : NULL;
+	void **slot;
+
+	if (!is_user_vaddr (va))
+		return NULL;
+	slot = spt_slot (spt, va, false);
+	return slot != NULL ? *slot : NULL;
 }
 
 /* Insert PAGE into spt with validation. */
 bool spt_insert_page(struct supplemental_page_table *spt UNUSED,
 					 struct page *page UNUSED)
 {
-	int succ = false;
-	/* TODO: Fill this function. */
-	struct hash_elem *e = hash_insert(&spt->pages, &page->hash_elem);
-	if (e == NULL) {
-		succ = true;
-	}
-	return succ;
+	void **slot;
+
+	if (!is_user_vaddr (page->va))
+		return false;
+	slot = spt_slot (spt, page->va, true);
+	if (slot == NULL || *slot != NULL)
+		return false;
+	*slot = page;
+	return true;
 }
 
 void spt_remove_page(struct supplemental_page_table *spt, struct page *page)
 {
-	hash_delete(&spt->pages, &page->hash_elem);
+	void **slot = spt_slot (spt, page->va, false);
+
+	if (slot != NULL && *slot == page)
+		*slot = NULL;
 	vm_dealloc_page(page);
-	return true;
 }
 
-/* Get the struct frame, that will be evicted. */
+/* Adds an area covering [START, END) to SPT and returns it, or
+ * returns NULL if the range is empty, overlaps an existing area,
+ * or memory runs out. */
+struct vm_area *
+spt_add_area (struct supplemental_page_table *spt, void *start, void *end,
+		enum vm_type type, bool writable, struct file *file, off_t ofs)
+{
+	struct vm_area *area;
+	struct list_elem *e;
+
+	ASSERT (pg_ofs (start) == 0 && pg_ofs (end) == 0);
+
+	if (start >= end || !is_user_vaddr (end - 1))
+		return NULL;
+	for (e = list_begin (&spt->areas); e != list_end (&spt->areas);
+			e = list_next (e)) {
+		struct vm_area *next = list_entry (e, struct vm_area, elem);
+		if (end <= next->start)
+			break;
+		if (start < next->end)
+			return NULL;
+	}
+
+	area = malloc (sizeof *area);
+	if (area == NULL)
+		return NULL;
+	area->start = start;
+	area->end = end;
+	area->type = type;
+	area->writable = writable;
+	area->file = file;
+	area->ofs = ofs;
+	area->advice = MADV_NORMAL;
+	area->ra_next = NULL;
+	area->ra_window = 0;
+	list_insert (e, &area->elem);
+	return area;
+}
+
+/* Returns the area of SPT that contains VA, or NULL if none does. */
+struct vm_area *
+spt_find_area (struct supplemental_page_table *spt, const void *va)
+{
+	struct list_elem *e;
+
+	for (e = list_begin (&spt->areas); e != list_end (&spt->areas);
+			e = list_next (e)) {
+		struct vm_area *area = list_entry (e, struct vm_area, elem);
+		if (va < area->start)
+			break;
+		if (va < area->end)
+			return area;
+	}
+	return NULL;
+}
+
+/* Removes AREA from SPT and frees it.  Its pages are not
+ * touched. */
+void
+spt_remove_area (struct supplemental_page_table *spt UNUSED,
+		struct vm_area *area)
+{
+	list_remove (&area->elem);
+	free (area);
+}
+
+/* Splits AREA in two at VA, which must lie strictly inside it, and
+ * returns the upper half.  Returns NULL if memory runs out. */
+static struct vm_area *
+spt_split_area (struct vm_area *area, void *va)
+{
+	struct vm_area *upper;
+
+	ASSERT (area->start < va && va < area->end && pg_ofs (va) == 0);
+
+	upper = malloc (sizeof *upper);
+	if (upper == NULL)
+		return NULL;
+	*upper = *area;
+	upper->start = va;
+	upper->ofs = area->ofs + (va - area->start);
+	upper->ra_next = NULL;
+	upper->ra_window = 0;
+	area->end = va;
+	list_insert (list_next (&area->elem), &upper->elem);
+	return upper;
+}
+
+/* Adds PAGE to the pages sharing FRAME.  The caller must hold
+ * frame_lock. */
+static void
+frame_link (struct frame *frame, struct page *page)
+{
+	ASSERT (lock_held_by_current_thread (&frame_lock));
+
+	list_push_back (&frame->pages, &page->share_elem);
+	frame->share_cnt++;
+	page->frame = frame;
+}
+
+/* Removes FRAME from the merge table, if it is there.  The caller
+ * must hold frame_lock. */
+static void
+ksm_forget (struct frame *frame)
+{
+	if (frame->ksm_listed) {
+		hash_delete (&ksm_table, &frame->ksm_elem);
+		frame->ksm_listed = false;
+	}
+}
+
+/* Removes FRAME from the text table, if it is there.  The caller
+ * must hold frame_lock. */
+static void
+text_forget (struct frame *frame)
+{
+	if (frame->text_listed) {
+		hash_delete (&text_table, &frame->text_elem);
+		frame->text_listed = false;
+	}
+}
+
+/* Removes PAGE from its frame and unmaps it from its owner's pml4.
+ * The frame goes back to the user pool once no page uses it. */
+static void
+frame_put_page (struct page *page)
+{
+	struct frame *frame = page->frame;
+
+	ASSERT (lock_held_by_current_thread (&frame_lock));
+
+	list_remove (&page->share_elem);
+	frame->share_cnt--;
+	page->frame = NULL;
+	pml4_clear_page (page->owner->pml4, page->va);
+	frame_release (frame);
+}
+
+/* Frees FRAME if no page uses it and nobody has it pinned.  The
+ * caller must hold frame_lock. */
+static void
+frame_release (struct frame *frame)
+{
+	ASSERT (lock_held_by_current_thread (&frame_lock));
+
+	if (frame->share_cnt == 0 && frame->pin_cnt == 0) {
+		ksm_forget (frame);
+		text_forget (frame);
+		palloc_free_page (frame->kva);
+		free_cnt++;
+	}
+}
+
+/* Waits until PAGE's frame, if any, is not being evicted.  The
+ * caller must hold frame_lock. */
+static void
+frame_wait (struct page *page)
+{
+	while (page->frame != NULL && page->frame->evicting)
+		cond_wait (&evict_cond, &frame_lock);
+}
+
+/* Returns true if any page of FRAME was accessed since the last
+ * call, clearing the accessed bits as it goes. */
+static bool
+frame_test_and_clear_accessed (struct frame *frame)
+{
+	bool accessed = false;
+
+	for (struct list_elem *e = list_begin (&frame->pages);
+			e != list_end (&frame->pages); e = list_next (e)) {
+		struct page *page = list_entry (e, struct page, share_elem);
+		uint64_t *pml4 = page->owner->pml4;
+
+		if (pml4_is_accessed (pml4, page->va)) {
+			pml4_set_accessed (pml4, page->va, false);
+			if (!page->drop_behind)
+				accessed = true;
+		}
+	}
+	return accessed;
+}
+
+/* Get the struct frame, that will be evicted.
+ * Second chance: the clock hand skips free and pinned frames, and
+ * clears the accessed bits of a recently used frame in its owners'
+ * pml4s instead of evicting it.  Two sweeps are enough to find a
+ * victim unless every frame is pinned, in which case this returns
+ * NULL.  The caller must hold frame_lock. */
 static struct frame *
 vm_get_victim(void)
 {
-	struct frame *victim = NULL;
-	/* TODO: The policy for eviction is up to you. */
-	for (struct list_elem *e = list_begin(&frame_table); e != list_end(&frame_table); e = list_next(e)) {
-		victim = list_entry(e, struct frame, frame_elem);
+	ASSERT (lock_held_by_current_thread (&frame_lock));
 
-		if (victim->page == NULL)
-			return victim;
+	for (size_t i = 0; i < 2 * frame_cnt; i++) {
+		struct frame *f = &frame_table[clock_hand];
 
-		if (!pml4_is_accessed(thread_current()->pml4, victim->page->va))
-			return victim;
-		
-		pml4_set_accessed(thread_current()->pml4, victim->page->va, 0);
+		clock_hand = (clock_hand + 1) % frame_cnt;
+		if (f->share_cnt == 0 || f->pin_cnt > 0)
+			continue;
+		if (frame_test_and_clear_accessed (f))
+			continue;
+		return f;
 	}
-	return victim;
+	return NULL;
+}
+
+/* Eviction runs in three steps so that frame_lock is not held
+ * while pages are written out.  evict_begin() pins VICTIM and
+ * unmaps all of its pages, so that an owner touching one of them
+ * faults and waits in frame_wait() until evict_end().  The caller
+ * must hold frame_lock. */
+static void
+evict_begin (struct frame *victim)
+{
+	ASSERT (lock_held_by_current_thread (&frame_lock));
+
+	victim->pin_cnt++;
+	victim->evicting = true;
+	for (struct list_elem *e = list_begin (&victim->pages);
+			e != list_end (&victim->pages); e = list_next (e)) {
+		struct page *page = list_entry (e, struct page, share_elem);
+		pml4_clear_page (page->owner->pml4, page->va);
+	}
+}
+
+/* Returns true if page A belongs before page B in a swap cluster:
+ * grouped by owner, in address order within an owner, so that a
+ * region's pages land in consecutive slots and can be read back
+ * together. */
+static bool
+cluster_less (const struct page *a, const struct page *b)
+{
+	if (a->owner != b->owner)
+		return a->owner < b->owner;
+	return a->va < b->va;
+}
+
+/* Swaps out the CNT anonymous pages in CLUSTER as one run of swap
+ * slots. */
+static void
+cluster_flush (struct page **cluster, size_t cnt)
+{
+	if (cnt == 0)
+		return;
+
+	/* Insertion sort; CNT is at most SWAP_CLUSTER_MAX. */
+	for (size_t i = 1; i < cnt; i++) {
+		struct page *page = cluster[i];
+		size_t j;
+
+		for (j = i; j > 0 && cluster_less (page, cluster[j - 1]); j--)
+			cluster[j] = cluster[j - 1];
+		cluster[j] = page;
+	}
+	if (!anon_swap_out_cluster (cluster, cnt))
+		PANIC ("evict_write: out of swap space");
+}
+
+/* Writes out every page of the CNT VICTIMS, which evict_begin()
+ * started evicting.  Every page sharing a frame is swapped out on
+ * its own.  Anonymous pages are gathered into clusters that go to
+ * consecutive swap slots with a single disk request.  The caller
+ * must not hold frame_lock, since writing may sleep on the disk and
+ * on inode locks. */
+static void
+evict_write (struct frame **victims, size_t cnt)
+{
+	struct page *cluster[SWAP_CLUSTER_MAX];
+	size_t cluster_cnt = 0;
+
+	for (size_t i = 0; i < cnt; i++) {
+		struct list *pages = &victims[i]->pages;
+
+		for (struct list_elem *e = list_begin (pages); e != list_end (pages);
+				e = list_next (e)) {
+			struct page *page = list_entry (e, struct page, share_elem);
+
+			if (VM_TYPE (page->operations->type) != VM_ANON) {
+				if (!swap_out (page))
+					PANIC ("evict_write: cannot write out page");
+				continue;
+			}
+			cluster[cluster_cnt++] = page;
+			if (cluster_cnt == SWAP_CLUSTER_MAX) {
+				cluster_flush (cluster, cluster_cnt);
+				cluster_cnt = 0;
+			}
+		}
+	}
+	cluster_flush (cluster, cluster_cnt);
 }
 
-/* Evict one page and return the corresponding frame.
- * Return NULL on error.*/
+/* Detaches the written-out pages from VICTIM and wakes the threads
+ * waiting for them.  VICTIM stays pinned for the caller.  The
+ * caller must hold frame_lock. */
+static void
+evict_end (struct frame *victim)
+{
+	ASSERT (lock_held_by_current_thread (&frame_lock));
+
+	while (!list_empty (&victim->pages)) {
+		struct page *page = list_entry (list_pop_front (&victim->pages),
+				struct page, share_elem);
+		page->frame = NULL;
+	}
+	victim->share_cnt = 0;
+	victim->evicting = false;
+	ksm_forget (victim);
+	text_forget (victim);
+	cond_broadcast (&evict_cond, &frame_lock);
+}
+
+/* Evict one page and return the corresponding frame, pinned.
+ * Return NULL on error.  The caller must hold frame_lock, which is
+ * released while the victim is written out. */
 static struct frame *
 vm_evict_frame(void)
 {
 	struct frame *victim = vm_get_victim();
-	//list_remove(&victim->frame_elem);
-	/* TODO: swap out the victim and return the evicted frame. */
-	swap_out(victim->page);
+
+	if (victim == NULL)
+		return NULL;
+
+	evict_begin (victim);
+	lock_release (&frame_lock);
+	evict_write (&victim, 1);
+	lock_acquire (&frame_lock);
+	evict_end (victim);
 	return victim;
 }
 
+/* Page-out daemon thread.  Evicts batches of frames back to the
+ * user pool until FREE_HIGH frames are free, then sleeps until
+ * vm_get_frame() finds fewer than FREE_LOW. */
+static void
+pageout_daemon (void *aux UNUSED)
+{
+	struct frame *batch[PAGEOUT_BATCH];
+
+	for (;;) {
+		sema_down (&pageout_sema);
+
+		lock_acquire (&frame_lock);
+		pageout_kicked = false;
+		while (free_cnt < free_high) {
+			size_t n = 0;
+
+			while (n < PAGEOUT_BATCH && free_cnt + n < free_high) {
+				struct frame *victim = vm_get_victim ();
+				if (victim == NULL)
+					break;
+				evict_begin (victim);
+				batch[n++] = victim;
+			}
+			if (n == 0)
+				break;
+
+			lock_release (&frame_lock);
+			evict_write (batch, n);
+			lock_acquire (&frame_lock);
+
+			for (size_t i = 0; i < n; i++) {
+				evict_end (batch[i]);
+				batch[i]->pin_cnt--;
+				palloc_free_page (batch[i]->kva);
+				free_cnt++;
+			}
+		}
+		lock_release (&frame_lock);
+	}
+}
+
+/* Returns the contents hash recorded in the frame that E is
+ * embedded in. */
+static uint64_t
+ksm_hash (const struct hash_elem *e, void *aux UNUSED)
+{
+	return hash_entry (e, struct frame, ksm_elem)->ksm_hash;
+}
+
+/* Orders frames by recorded contents hash, so that the merge table
+ * holds at most one frame per hash. */
+static bool
+ksm_less (const struct hash_elem *a, const struct hash_elem *b,
+		void *aux UNUSED)
+{
+	return hash_entry (a, struct frame, ksm_elem)->ksm_hash
+		< hash_entry (b, struct frame, ksm_elem)->ksm_hash;
+}
+
+/* Returns true if FRAME may be merged: in use, not pinned or being
+ * evicted, and holding only anonymous pages.  File-backed pages are
+ * left alone because they are written back to their own files.
+ * The caller must hold frame_lock. */
+static bool
+ksm_mergeable (struct frame *frame)
+{
+	if (frame == zero_frame)
+		return true;
+	if (frame->share_cnt == 0 || frame->pin_cnt > 0 || frame->evicting)
+		return false;
+	for (struct list_elem *e = list_begin (&frame->pages);
+			e != list_end (&frame->pages); e = list_next (e)) {
+		struct page *page = list_entry (e, struct page, share_elem);
+		if (VM_TYPE (page->operations->type) != VM_ANON)
+			return false;
+	}
+	return true;
+}
+
+/* Maps every page of FRAME read-only, so that FRAME's contents cannot
+ * change until frame_lock is released.  The caller must hold
+ * frame_lock. */
+static void
+ksm_write_protect (struct frame *frame)
+{
+	for (struct list_elem *e = list_begin (&frame->pages);
+			e != list_end (&frame->pages); e = list_next (e)) {
+		struct page *page = list_entry (e, struct page, share_elem);
+		pml4_set_writable (page->owner->pml4, page->va, false);
+	}
+}
+
+/* If FRAME's contents equal DST's, moves all of FRAME's pages to DST,
+ * read-only, frees FRAME and returns true.  Both frames must be
+ * mergeable.  The caller must hold frame_lock. */
+static bool
+ksm_merge (struct frame *frame, struct frame *dst)
+{
+	ksm_write_protect (frame);
+	if (dst != zero_frame)
+		ksm_write_protect (dst);
+	if (memcmp (frame->kva, dst->kva, PGSIZE))
+		return false;
+
+	while (!list_empty (&frame->pages)) {
+		struct page *page = list_entry (list_pop_front (&frame->pages),
+				struct page, share_elem);
+
+		pml4_clear_page (page->owner->pml4, page->va);
+		pml4_set_page (page->owner->pml4, page->va, dst->kva, false);
+		frame_link (dst, page);
+	}
+	frame->share_cnt = 0;
+	ksm_forget (frame);
+	text_forget (frame);
+	palloc_free_page (frame->kva);
+	free_cnt++;
+	return true;
+}
+
+/* Hashes FRAME and merges it into the frame in the merge table with
+ * the same hash, or enters it into the table if there is none.  The
+ * caller must hold frame_lock. */
+static void
+ksm_scan_frame (struct frame *frame)
+{
+	struct frame key;
+	struct hash_elem *e;
+	struct frame *match;
+	uint64_t hash;
+
+	if (frame == zero_frame || !ksm_mergeable (frame))
+		return;
+
+	hash = hash_bytes (frame->kva, PGSIZE);
+	if (frame->ksm_listed) {
+		if (frame->ksm_hash == hash)
+			return;
+		ksm_forget (frame);
+	}
+	frame->ksm_hash = hash;
+
+	key.ksm_hash = hash;
+	e = hash_find (&ksm_table, &key.ksm_elem);
+	if (e != NULL) {
+		match = hash_entry (e, struct frame, ksm_elem);
+		if (ksm_mergeable (match) && ksm_merge (frame, match))
+			return;
+
+		/* MATCH has changed since it was hashed.  FRAME takes its
+		   place. */
+		ksm_forget (match);
+	}
+	hash_insert (&ksm_table, &frame->ksm_elem);
+	frame->ksm_listed = true;
+}
+
+/* Same-page merging daemon thread.  Runs at the lowest priority and
+ * sweeps the frame table a batch at a time, releasing frame_lock
+ * between frames so that faults are not held up for long. */
+static void
+ksm_daemon (void *aux UNUSED)
+{
+	for (;;) {
+		timer_sleep (KSM_SLEEP);
+
+		for (size_t i = 0; i < KSM_SCAN_BATCH; i++) {
+			lock_acquire (&frame_lock);
+			ksm_scan_frame (&frame_table[ksm_hand]);
+			ksm_hand = (ksm_hand + 1) % frame_cnt;
+			lock_release (&frame_lock);
+		}
+	}
+}
+
 /* palloc() and get frame. If there is no available page, evict the page
  * and return it. This always return valid address. That is, if the user pool
  * memory is full, this function evicts the frame to get the available memory
@@ -166,40 +781,506 @@ vm_get_frame(void)
 
 	//유저 메모리 풀에서 페이지를 성공적으로 가져오면, 
 	//프레임을 할당하고 프레임 구조체의 멤버들을 초기화한 후 해당 프레임을 반환
-	frame = malloc(sizeof(struct frame));
 	void *kva = palloc_get_page(PAL_USER);
 
-	if(kva != NULL){
+	lock_acquire (&frame_lock);
+	if (kva != NULL) {
+		frame = &frame_table[palloc_user_page_idx (kva)];
 		frame->kva = kva;
-	}else{
-		free(frame);
-		frame=vm_evict_frame(); //쫓아냄
-		frame->page = NULL;
-		return frame;
+		frame->pin_cnt = 1;
+		free_cnt--;
+	} else {
+		//데몬이 따라잡지 못했을 때만 직접 쫓아냄
+		frame = vm_evict_frame();
+		if (frame == NULL)
+			PANIC ("vm_get_frame: no frame to evict");
 	}
+	/* Pinned until the caller has filled it in. */
+	ASSERT (frame->pin_cnt == 1);
 
-	list_push_back(&frame_table,&frame->frame_elem);
+	if (free_cnt < free_low && !pageout_kicked) {
+		pageout_kicked = true;
+		sema_up (&pageout_sema);
+	}
+	lock_release (&frame_lock);
 
-	frame->page = NULL;
 	ASSERT (frame != NULL);
-	ASSERT (frame->page == NULL);
+	ASSERT (frame->share_cnt == 0);
+
+	return frame;
+}
+
+/* Returns a pinned free frame without evicting anything, or NULL
+ * if that would take free frames down to the low watermark.  For
+ * readahead, which must not push other pages out. */
+static struct frame *
+vm_try_get_frame (void)
+{
+	struct frame *frame = NULL;
 
+	lock_acquire (&frame_lock);
+	if (free_cnt > free_low) {
+		void *kva = palloc_get_page (PAL_USER);
+		if (kva != NULL) {
+			frame = &frame_table[palloc_user_page_idx (kva)];
+			frame->kva = kva;
+			frame->pin_cnt = 1;
+			free_cnt--;
+		}
+	}
+	lock_release (&frame_lock);
 	return frame;
 }
 
-/* Growing the stack. */
+/* Releases PAGE's hold on its frame, if any, and unmaps PAGE so that
+ * pml4_destroy() does not free the frame a second time. */
+void
+vm_free_frame (struct page *page)
+{
+	lock_acquire (&frame_lock);
+	frame_wait (page);
+	if (page->frame != NULL)
+		frame_put_page (page);
+	lock_release (&frame_lock);
+}
+
+/* Makes DST, an uninit page in the current thread's spt, share
+ * SRC's frame copy-on-write, and write-protects SRC.  Returns false
+ * if SRC is not in memory or on failure. */
+static bool
+frame_share (struct page *src, struct page *dst)
+{
+	struct frame *frame;
+	bool success = false;
+
+	lock_acquire (&frame_lock);
+	frame_wait (src);
+	frame = src->frame;
+	if (frame != NULL) {
+		/* DST has no lazy loader, so this only sets up its type. */
+		success = swap_in (dst, frame->kva)
+			&& pml4_set_page (dst->owner->pml4, dst->va, frame->kva, false);
+		if (success) {
+			frame_link (frame, dst);
+			pml4_set_writable (src->owner->pml4, src->va, false);
+		}
+	}
+	lock_release (&frame_lock);
+	return success;
+}
+
+/* Grows the stack in AREA down to ADDR, a page that is not in the
+ * spt yet.  That page is only reserved here.  The fault is then
+ * handled like any other, so stack that is only read stays on the
+ * zero page.  Up to stack_grow_pages - 1 pages below it are added
+ * as well, and each one that gets a free frame is mapped at once,
+ * zeroed, so a deep recursion faults once per chunk rather than
+ * once per page.  Growth stops at the bottom of AREA and at the
+ * first page that is already there. */
 static void
-vm_stack_growth(void *addr UNUSED)
+vm_stack_growth(struct vm_area *area, void *addr)
 {
+	struct supplemental_page_table *spt = &thread_current ()->spt;
+	void *va = pg_round_down (addr);
+	size_t i;
+
 	/* anonymous 페이지를 할당하여 스택 크기를 늘림 */
-	vm_alloc_page_with_initializer (VM_ANON,addr, 1, NULL, NULL);
-	vm_claim_page(addr);
+	if (!vm_alloc_page_with_initializer (VM_ANON, va, 1, NULL, NULL))
+		return;
+	stack_fault_cnt++;
+	stack_page_cnt++;
+
+	for (i = 1; i < stack_grow_pages; i++) {
+		struct page *page;
+		struct frame *frame;
+		bool ok;
+
+		va -= PGSIZE;
+		if (va < area->start || !vm_alloc_page (VM_ANON, va, true))
+			break;
+		stack_page_cnt++;
+		page = spt_find_page (spt, va);
+		if ((frame = vm_try_get_frame ()) == NULL)
+			break;
+		memset (frame->kva, 0, PGSIZE);
+		lock_acquire (&frame_lock);
+		frame_link (frame, page);
+		ok = swap_in (page, frame->kva)
+			&& pml4_set_page (page->owner->pml4, va, frame->kva, true);
+		frame->pin_cnt--;
+		if (!ok)
+			frame_put_page (page);
+		lock_release (&frame_lock);
+		if (!ok)
+			break;
+	}
+}
+
+/* Prints VM statistics. */
+void
+vm_print_stats (void)
+{
+	printf ("VM: %lld stack growth faults, %lld stack pages added\n",
+			stack_fault_cnt, stack_page_cnt);
+}
+
+/* Returns true if PAGE is an anonymous page whose contents were
+ * discarded, by MADV_DONTNEED or MADV_FREE, and so are all zeros. */
+static bool
+page_is_blank (struct page *page)
+{
+	return VM_TYPE (page->operations->type) == VM_ANON
+		&& page->frame == NULL && page->anon.swap_index == -1
+		&& page->anon.zentry == NULL && page->anon.text == NULL
+		&& page->anon.segment == NULL;
+}
+
+/* On a read fault, maps the shared zero frame read-only at PAGE, an
+ * untouched or discarded anonymous page with nothing to load.  The
+ * first write fault then gives PAGE a private copy in
+ * vm_handle_wp().  Returns false if PAGE is any other kind of
+ * page. */
+static bool
+vm_map_zero_page(struct page *page)
+{
+	bool uninit = VM_TYPE (page->operations->type) == VM_UNINIT;
+	bool success;
+
+	if (uninit ? VM_TYPE (page->uninit.type) != VM_ANON
+				|| page->uninit.init != NULL
+			: !page_is_blank (page))
+		return false;
+
+	lock_acquire (&frame_lock);
+	/* An uninit PAGE has no lazy loader, so this only sets up its
+	   type. */
+	success = (!uninit || swap_in (page, zero_frame->kva))
+		&& pml4_set_page (page->owner->pml4, page->va, zero_frame->kva, false);
+	if (success)
+		frame_link (zero_frame, page);
+	lock_release (&frame_lock);
+	return success;
+}
+
+/* Hashes the file range recorded in the frame that E is embedded
+ * in. */
+static uint64_t
+text_hash (const struct hash_elem *e, void *aux UNUSED)
+{
+	const struct frame *f = hash_entry (e, struct frame, text_elem);
+	uint64_t key[3] = { (uint64_t) f->text_inode, f->text_ofs, f->text_len };
+
+	return hash_bytes (key, sizeof key);
+}
+
+/* Orders frames by the file range recorded in them. */
+static bool
+text_less (const struct hash_elem *a_, const struct hash_elem *b_,
+		void *aux UNUSED)
+{
+	const struct frame *a = hash_entry (a_, struct frame, text_elem);
+	const struct frame *b = hash_entry (b_, struct frame, text_elem);
+
+	if (a->text_inode != b->text_inode)
+		return a->text_inode < b->text_inode;
+	if (a->text_ofs != b->text_ofs)
+		return a->text_ofs < b->text_ofs;
+	return a->text_len < b->text_len;
+}
+
+/* Returns where to load PAGE from if it is a read-only page of an
+ * executable segment, or NULL otherwise. */
+static struct lazy_load_info *
+page_text (struct page *page)
+{
+	if (page->writable)
+		return NULL;
+	if (VM_TYPE (page->operations->type) == VM_UNINIT)
+		return VM_TYPE (page->uninit.type) == VM_ANON
+			&& page->uninit.init == lazy_load_segment ? page->uninit.aux : NULL;
+	if (VM_TYPE (page->operations->type) == VM_ANON)
+		return page->anon.text;
+	return NULL;
+}
+
+/* Returns the frame in the text table holding TEXT, or NULL if
+ * there is none.  The caller must hold frame_lock. */
+static struct frame *
+text_lookup (struct lazy_load_info *text)
+{
+	struct frame key;
+	struct hash_elem *e;
+
+	key.text_inode = file_get_inode (text->file);
+	key.text_ofs = text->ofs;
+	key.text_len = text->page_read_bytes;
+	e = hash_find (&text_table, &key.text_elem);
+	return e != NULL ? hash_entry (e, struct frame, text_elem) : NULL;
 }
 
-/* Handle the fault on write_protected page */
+/* Enters the frame of PAGE, just loaded from TEXT, in the text
+ * table, unless it is already there or on its way out. */
+static void
+text_publish (struct page *page, struct lazy_load_info *text)
+{
+	struct frame *frame;
+
+	lock_acquire (&frame_lock);
+	frame = page->frame;
+	if (frame != NULL && !frame->evicting && !frame->text_listed) {
+		frame->text_inode = file_get_inode (text->file);
+		frame->text_ofs = text->ofs;
+		frame->text_len = text->page_read_bytes;
+		if (hash_insert (&text_table, &frame->text_elem) == NULL)
+			frame->text_listed = true;
+	}
+	lock_release (&frame_lock);
+}
+
+/* If another process already has TEXT in a frame, maps PAGE, a
+ * read-only page of an executable segment loaded from TEXT, to
+ * that frame and returns true.  Otherwise returns false. */
+static bool
+vm_share_text_page (struct page *page, struct lazy_load_info *text)
+{
+	struct frame *frame;
+	bool success = false;
+
+	lock_acquire (&frame_lock);
+	frame = text_lookup (text);
+	if (frame != NULL && !frame->evicting) {
+		/* Skip lazy_load_segment(); the frame is already loaded. */
+		if (VM_TYPE (page->operations->type) == VM_UNINIT)
+			anon_initializer (page, VM_ANON, frame->kva);
+		page->anon.text = text;
+		success = pml4_set_page (page->owner->pml4, page->va, frame->kva,
+				false);
+		if (success)
+			frame_link (frame, page);
+	}
+	lock_release (&frame_lock);
+	return success;
+}
+
+/* Claims PAGE, a read-only page of an executable segment loaded
+ * from TEXT.  If another process already has the same page of the
+ * same executable in a frame, PAGE just shares it.  Otherwise PAGE
+ * is loaded as usual and its frame entered in the text table. */
+static bool
+vm_claim_text_page (struct page *page, struct lazy_load_info *text)
+{
+	if (vm_share_text_page (page, text))
+		return true;
+	if (!vm_do_claim_page (page))
+		return false;
+	page->anon.text = text;
+	text_publish (page, text);
+	return true;
+}
+
+/* If PAGE is not in memory and can be read straight from a file,
+ * stores where into *FILE, *OFS and *READ_BYTES and returns true.
+ * The rest of the page is zeros. */
+static bool
+page_file_range (struct page *page, struct file **file, off_t *ofs,
+		uint32_t *read_bytes)
+{
+	switch (VM_TYPE (page->operations->type)) {
+		case VM_UNINIT: {
+			struct lazy_load_info *aux = page->uninit.aux;
+
+			if (page->uninit.init != lazy_load_segment)
+				return false;
+			*file = aux->file;
+			*ofs = aux->ofs;
+			*read_bytes = aux->page_read_bytes;
+			return true;
+		}
+		case VM_FILE:
+			*file = page->file.file;
+			*ofs = page->file.file_ofs;
+			*read_bytes = page->file.read_bytes;
+			return true;
+		case VM_ANON:
+			/* Evicted executable text, which is dropped rather than
+			   swapped. */
+			if (page->anon.text == NULL || page->anon.swap_index != -1
+					|| page->anon.zentry != NULL)
+				return false;
+			*file = page->anon.text->file;
+			*ofs = page->anon.text->ofs;
+			*read_bytes = page->anon.text->page_read_bytes;
+			return true;
+		default:
+			return false;
+	}
+}
+
+/* Brings in PAGE, which is not present and backed by a file,
+ * together with up to FAULT_AROUND_MAX - 1 of the pages that
+ * follow it in the same area and the same file, reading them all
+ * with one file_read_pages().  The window starts at
+ * FAULT_AROUND_MIN pages and doubles with each fault that lands
+ * right after the last window, so a linear scan faults ever more
+ * rarely.  Like swap readahead, the extra pages only take free
+ * frames and are mapped without their accessed bits.
+ *
+ * Returns false if PAGE is not a candidate or no neighbour could
+ * join it, leaving PAGE to the ordinary fault path.  Otherwise
+ * returns true and stores in *SUCCESS whether PAGE was loaded. */
+static bool
+vm_fault_around (struct page *page, bool *success)
+{
+	struct supplemental_page_table *spt = &page->owner->spt;
+	struct vm_area *area = spt_find_area (spt, page->va);
+	struct page *pages[FAULT_AROUND_MAX];
+	uint32_t reads[FAULT_AROUND_MAX];
+	void *kvas[FAULT_AROUND_MAX];
+	struct frame *frame;
+	struct file *file;
+	off_t ofs, got;
+	size_t window, cnt, i;
+	bool present;
+
+	if (area == NULL || !page_file_range (page, &file, &ofs, &reads[0])
+			|| reads[0] == 0)
+		return false;
+
+	lock_acquire (&frame_lock);
+	frame_wait (page);
+	present = page->frame != NULL;
+	lock_release (&frame_lock);
+	if (present)
+		return false;
+
+	if (area->advice == MADV_RANDOM)
+		return false;
+	if (area->advice == MADV_SEQUENTIAL)
+		window = FAULT_AROUND_MAX;
+	else
+		window = page->va == area->ra_next ? area->ra_window * 2
+			: FAULT_AROUND_MIN;
+	if (window > FAULT_AROUND_MAX)
+		window = FAULT_AROUND_MAX;
+
+	pages[0] = page;
+	for (cnt = 1; cnt < window; cnt++) {
+		void *va = page->va + cnt * PGSIZE;
+		struct page *next;
+		struct lazy_load_info *text;
+		struct file *next_file;
+		off_t next_ofs;
+		bool absent;
+
+		if (va >= area->end || reads[cnt - 1] != PGSIZE)
+			break;
+		next = spt_find_page (spt, va);
+		if (next == NULL
+				|| !page_file_range (next, &next_file, &next_ofs, &reads[cnt])
+				|| file_get_inode (next_file) != file_get_inode (file)
+				|| next_ofs != ofs + (off_t) (cnt * PGSIZE) || reads[cnt] == 0)
+			break;
+
+		/* Text another process has in memory is shared, not read. */
+		text = page_text (next);
+		lock_acquire (&frame_lock);
+		absent = next->frame == NULL
+			&& (text == NULL || text_lookup (text) == NULL);
+		lock_release (&frame_lock);
+		if (!absent || (frame = vm_try_get_frame ()) == NULL)
+			break;
+		lock_acquire (&frame_lock);
+		frame_link (frame, next);
+		lock_release (&frame_lock);
+		pages[cnt] = next;
+	}
+
+	area->ra_next = page->va + cnt * PGSIZE;
+	area->ra_window = window;
+	if (cnt == 1)
+		return false;
+
+	frame = vm_get_frame ();
+	lock_acquire (&frame_lock);
+	frame_link (frame, page);
+	lock_release (&frame_lock);
+	for (i = 0; i < cnt; i++)
+		kvas[i] = pages[i]->frame->kva;
+	got = file_read_pages (file, kvas, cnt, ofs);
+
+	*success = true;
+	for (i = 0; i < cnt; i++) {
+		struct page *p = pages[i];
+		struct lazy_load_info *text = page_text (p);
+		bool ok = got >= (off_t) (i * PGSIZE + reads[i]);
+
+		memset (kvas[i] + reads[i], 0, PGSIZE - reads[i]);
+		/* Skip lazy_load_segment(); the frame is already loaded. */
+		if (ok && VM_TYPE (p->operations->type) == VM_UNINIT)
+			ok = p->uninit.page_initializer (p, p->uninit.type, kvas[i]);
+		if (ok)
+			ok = pml4_set_page (p->owner->pml4, p->va, kvas[i], p->writable);
+
+		lock_acquire (&frame_lock);
+		p->frame->pin_cnt--;
+		lock_release (&frame_lock);
+		if (!ok) {
+			if (i == 0)
+				*success = false;
+			vm_free_frame (p);
+			continue;
+		}
+		if (text != NULL) {
+			p->anon.text = text;
+			text_publish (p, text);
+		}
+	}
+	return true;
+}
+
+/* Handle the fault on write_protected page.
+ * PAGE is writable but shares its frame copy-on-write.  The last
+ * page left on a frame takes it over; any other gets a copy, and so
+ * does every page on the zero frame. */
 static bool
-vm_handle_wp(struct page *page UNUSED)
+vm_handle_wp(struct page *page)
 {
+	struct frame *old, *frame;
+	bool success;
+
+	lock_acquire (&frame_lock);
+	frame_wait (page);
+	old = page->frame;
+	if (old == NULL) {
+		/* Evicted since the fault; fault it back in privately. */
+		lock_release (&frame_lock);
+		return vm_do_claim_page (page);
+	}
+	if (old->share_cnt == 1 && old != zero_frame) {
+		pml4_set_writable (page->owner->pml4, page->va, true);
+		lock_release (&frame_lock);
+		return true;
+	}
+	old->pin_cnt++;
+	lock_release (&frame_lock);
+
+	frame = vm_get_frame ();
+	memcpy (frame->kva, old->kva, PGSIZE);
+
+	/* Both frames stay pinned until PAGE is mapped to the copy, so
+	   neither can be evicted in between. */
+	lock_acquire (&frame_lock);
+	frame_put_page (page);
+	frame_link (frame, page);
+	success = pml4_set_page (page->owner->pml4, page->va, frame->kva, true);
+	if (!success)
+		frame_put_page (page);
+	frame->pin_cnt--;
+	frame_release (frame);
+	old->pin_cnt--;
+	frame_release (old);
+	lock_release (&frame_lock);
+	return success;
 }
 
 /* Return true on success */
@@ -218,20 +1299,41 @@ bool vm_try_handle_fault(struct intr_frame *f UNUSED, void *addr UNUSED,
 
 	if (not_present) {
 		rsp = (user == true)? f->rsp : thread_current()->user_rsp;
-		if (USER_STACK - USER_STK_LIMIT <= rsp - 8 && rsp - 8 <= addr && addr <= USER_STACK) {
-			vm_stack_growth(pg_round_down(addr));
-			return true;
-		}
-		
 		page = spt_find_page(spt, addr);
-		if (page == NULL)
-			return false;
+		if (page == NULL) {
+			/* 스택 영역 안에서 rsp 근처를 건드렸으면 스택을 키운다.
+			   한계는 exec 때 잡아 둔 스택 영역의 크기다. */
+			struct vm_area *area = spt_find_area (spt, addr);
+
+			if (area == NULL || area->end != (void *) USER_STACK
+					|| (void *) (rsp - 8) > addr)
+				return false;
+			vm_stack_growth (area, addr);
+			page = spt_find_page(spt, addr);
+			if (page == NULL)
+				return false;
+		}
 
 		if (write == 1 && page->writable == 0)
 			return false;
 
+		if (!write && vm_map_zero_page(page))
+			return true;
+		struct lazy_load_info *text = page_text(page);
+		if (text != NULL && vm_share_text_page(page, text))
+			return true;
+		bool success;
+		if (vm_fault_around(page, &success))
+			return success;
+		if (text != NULL)
+			return vm_claim_text_page(page, text);
 		return vm_do_claim_page(page);
 	}
+
+	/* 쓰기 가능한 페이지에 대한 write fault는 copy-on-write */
+	page = spt_find_page(spt, addr);
+	if (page != NULL && write && page->writable)
+		return vm_handle_wp(page);
 	/*이 함수에서는 Page Fault가 스택을 증가시켜야하는 경우에 해당하는지 아닌지를 확인해야 합니다.
 	스택 증가로 Page Fault 예외를 처리할 수 있는지 확인한 경우, 
 	Page Fault가 발생한 주소로 vm_stack_growth를 호출합니다.*/
@@ -264,42 +1366,188 @@ bool vm_claim_page(void *va UNUSED)
 	return vm_do_claim_page(page);
 }
 
+/* Swaps in PAGE, an anonymous page in swap that has just been
+ * linked to a frame, together with up to SWAP_READAHEAD - 1 of the
+ * pages that follow it in its owner's address space, as long as
+ * their swap slots follow PAGE's and free frames are plentiful.
+ * Clustered eviction puts neighbouring pages in neighbouring slots,
+ * so one disk request often brings back a whole run.  The extra
+ * pages are mapped but not marked accessed, so the clock takes them
+ * back first if they go unused.  Areas advised MADV_RANDOM get no
+ * readahead. */
+static void
+vm_swap_in_readahead (struct page *page)
+{
+	struct vm_area *area = spt_find_area (&page->owner->spt, page->va);
+	size_t max = area != NULL && area->advice == MADV_RANDOM
+		? 1 : SWAP_READAHEAD;
+	struct page *pages[SWAP_READAHEAD];
+	size_t cnt = 1;
+
+	pages[0] = page;
+	while (cnt < max) {
+		struct page *next = spt_find_page (&page->owner->spt,
+				page->va + cnt * PGSIZE);
+		struct frame *frame;
+		bool swapped;
+
+		if (next == NULL || VM_TYPE (next->operations->type) != VM_ANON)
+			break;
+		lock_acquire (&frame_lock);
+		swapped = next->frame == NULL
+			&& next->anon.swap_index == page->anon.swap_index + (int) cnt;
+		lock_release (&frame_lock);
+		if (!swapped || (frame = vm_try_get_frame ()) == NULL)
+			break;
+		lock_acquire (&frame_lock);
+		frame_link (frame, next);
+		lock_release (&frame_lock);
+		pages[cnt++] = next;
+	}
+
+	anon_swap_in_cluster (pages, cnt);
+
+	for (size_t i = 1; i < cnt; i++) {
+		struct frame *frame = pages[i]->frame;
+
+		pml4_set_page (pages[i]->owner->pml4, pages[i]->va, frame->kva,
+				pages[i]->writable);
+		lock_acquire (&frame_lock);
+		frame->pin_cnt--;
+		lock_release (&frame_lock);
+	}
+}
+
 /* Claim the PAGE and set up the mmu. */
 static bool
 vm_do_claim_page(struct page *page)
 {
-	struct thread *t = thread_current();
-	struct frame *frame = vm_get_frame();
+	struct frame *frame;
+	bool success;
+
+	/* A page being evicted is not present, so its owner may fault
+	   on it before it is written out. */
+	lock_acquire (&frame_lock);
+	frame_wait (page);
+	lock_release (&frame_lock);
+	if (page->frame != NULL)
+		return true;
+
+	frame = vm_get_frame();
 
 	/* Set links */
-	frame->page = page;
-	page->frame = frame;
+	lock_acquire (&frame_lock);
+	frame_link(frame, page);
+	lock_release (&frame_lock);
 
 	/* TODO: Insert page table entry to map page's VA to frame's PA. */
-	pml4_set_page(t->pml4, page->va, frame->kva, page->writable);
+	/* PAGE may belong to the parent while fork copies its spt. */
+	pml4_set_page(page->owner->pml4, page->va, frame->kva, page->writable);
 
-	return swap_in(page, frame->kva);
+	if (VM_TYPE (page->operations->type) == VM_ANON
+			&& page->anon.swap_index != -1) {
+		vm_swap_in_readahead (page);
+		success = true;
+	} else
+		success = swap_in(page, frame->kva);
+	lock_acquire (&frame_lock);
+	frame->pin_cnt--;
+	lock_release (&frame_lock);
+	return success;
 }
 
-unsigned
-supplemental_page_hash (const struct hash_elem *p_, void *aux UNUSED) {
-  const struct page *p = hash_entry (p_, struct page, hash_elem);
-  return hash_bytes (&p->va, sizeof p->va);
+/* Returns the slot for VA, which must be a user address, in the
+ * radix tree of SPT.  Missing nodes on the way are allocated if
+ * CREATE is true; otherwise, or if memory runs out, returns NULL
+ * when one is missing. */
+static void **
+spt_slot (struct supplemental_page_table *spt, const void *va, bool create)
+{
+	uint64_t vpn = pg_no (va);
+	struct spt_node **node = &spt->root;
+	int level;
+
+	ASSERT (vpn < (1ULL << (SPT_BITS * SPT_LEVELS)));
+
+	for (level = SPT_LEVELS - 1; ; level--) {
+		void **slot;
+
+		if (*node == NULL) {
+			if (!create)
+				return NULL;
+			*node = calloc (1, sizeof **node);
+			if (*node == NULL)
+				return NULL;
+		}
+		slot = &(*node)->slot[(vpn >> (level * SPT_BITS)) & (SPT_FANOUT - 1)];
+		if (level == 0)
+			return slot;
+		node = (struct spt_node **) slot;
+	}
 }
 
-bool
-supplemental_page_less (const struct hash_elem *a_,
-           const struct hash_elem *b_, void *aux UNUSED) {
-  const struct page *a = hash_entry (a_, struct page, hash_elem);
-  const struct page *b = hash_entry (b_, struct page, hash_elem);
+/* Calls ACTION on each page under NODE, at LEVEL of the radix
+ * tree, whose page number lies in [LO, HI), in address order.  NODE
+ * covers the page numbers from BASE on.  Subtrees outside the range
+ * are skipped without being visited.  If UNLINK is true, each page's
+ * slot is cleared once ACTION returns.  Stops early if ACTION
+ * returns false, and then returns false. */
+static bool
+spt_walk (struct spt_node *node, int level, uint64_t base, uint64_t lo,
+		uint64_t hi, spt_action_func *action, void *aux, bool unlink)
+{
+	uint64_t span = 1ULL << (level * SPT_BITS);
+	size_t i = lo > base ? (lo - base) / span : 0;
 
-  return a->va < b->va;
+	if (node == NULL)
+		return true;
+	for (; i < SPT_FANOUT && base + i * span < hi; i++) {
+		bool ok;
+
+		if (node->slot[i] == NULL)
+			continue;
+		if (level == 0) {
+			ok = action (node->slot[i], aux);
+			if (unlink)
+				node->slot[i] = NULL;
+		} else
+			ok = spt_walk (node->slot[i], level - 1, base + i * span,
+					lo, hi, action, aux, unlink);
+		if (!ok)
+			return false;
+	}
+	return true;
+}
+
+/* Walks the pages of SPT in [START, END) with spt_walk(). */
+static bool
+spt_walk_range (struct supplemental_page_table *spt, void *start,
+		void *end, spt_action_func *action, void *aux, bool unlink)
+{
+	return spt_walk (spt->root, SPT_LEVELS - 1, 0, pg_no (start),
+			pg_no (end), action, aux, unlink);
+}
+
+/* Frees NODE, at LEVEL of the radix tree, and the nodes below it,
+ * but not the pages. */
+static void
+spt_free_nodes (struct spt_node *node, int level)
+{
+	size_t i;
+
+	if (node == NULL)
+		return;
+	if (level > 0)
+		for (i = 0; i < SPT_FANOUT; i++)
+			spt_free_nodes (node->slot[i], level - 1);
+	free (node);
 }
 
 /* Initialize new supplemental page table */
 void supplemental_page_table_init(struct supplemental_page_table *spt UNUSED)
 {
-	hash_init (&spt->pages, supplemental_page_hash, supplemental_page_less, NULL);
+	spt->root = NULL;
+	list_init (&spt->areas);
 }
 
 /* Copy supplemental page table from src to dst */
@@ -308,49 +1556,171 @@ bool supplemental_page_table_copy(struct supplemental_page_table *dst UNUSED,
 {
 	/* src의 supplemental page table를 반복하면서
 	dst의 supplemental page table의 엔트리의 정확한 복사본을 만드세요 */
-	/* 해시 테이블의 요소 하나하나에 대해 action() 을 임의의 순서로 호출합니다.  */
-	struct hash_iterator spt_iterator;
-	hash_first (&spt_iterator, &src->pages);
-
-	while (hash_next (&spt_iterator)) {
-		struct page *src_page = hash_entry (hash_cur (&spt_iterator), struct page, hash_elem);
-		if (VM_TYPE(src_page->operations->type) == VM_UNINIT) {
-			vm_alloc_page_with_initializer(src_page->uninit.type, src_page->va, src_page->writable, src_page->uninit.init, src_page->uninit.aux);
-			continue;
-		}
-		if (src_page->operations->type == VM_ANON)
-		{
-			vm_alloc_page(src_page->operations->type, src_page->va, src_page->writable);
-			struct page *dst_page = spt_find_page(dst, src_page->va);
-			vm_claim_page(src_page->va);
-			memcpy (dst_page->frame->kva, src_page->frame->kva, (size_t)PGSIZE);
-		}
-		else if (src_page->operations->type == VM_FILE)
-		{
-			struct lazy_load_info *aux = (struct lazy_load_info*)malloc(sizeof(struct lazy_load_info));
-			/* src initializer가 호출될 때 file_page 구조체 내에 저장해 둔 file/ofs/read_bytes를 꺼낸다. */
-			/* 같은 파일이 아닌 복제한 파일을 넣어 준다. 자식이 파일을 쓰고 닫아 버리면 접근할 수 없기 때문(?) */
-			aux->file = file_duplicate(src_page->file.file);
-			aux->ofs = src_page->file.file_ofs;
-			aux->page_read_bytes = src_page->file.read_bytes;
-
-			vm_alloc_page_with_initializer(src_page->operations->type, src_page->va, src_page->writable, NULL, aux);
-			struct page *dst_page = spt_find_page(dst, src_page->va);
-
-			/* dst_page의 경우 프레임 할당받지 않기 때문에, initializer가 호출되지 않는다. 따라서 직접 initializer를 호출 */
-			file_backed_initializer(dst_page, VM_FILE, NULL);
-			pml4_set_page(thread_current()->pml4, dst_page->va, src_page->frame->kva, src_page->writable);
-			dst_page->frame = src_page->frame;
-		}
+	struct vm_area *prev = NULL, *prev_copy = NULL;
+	struct list_elem *e;
+
+	for (e = list_begin (&src->areas); e != list_end (&src->areas);
+			e = list_next (e)) {
+		struct vm_area *area = list_entry (e, struct vm_area, elem);
+		struct vm_area *copy = spt_add_area (dst, area->start, area->end,
+				area->type, area->writable, NULL, area->ofs);
+		if (copy == NULL)
+			return false;
+		copy->advice = area->advice;
+		if (area->type != VM_FILE)
+			/* load_segment()의 영역은 실행 파일을 가리킨다.  자식은
+			   그것을 자기 running으로 다시 열어 두었다. */
+			copy->file = area->file != NULL ? thread_current ()->running : NULL;
+		else if (prev != NULL && prev->file == area->file
+				&& prev->end == area->start)
+			/* madvise()로 쪼개진 같은 매핑은 파일 하나를 같이 쓴다. */
+			copy->file = prev_copy->file;
+		else if ((copy->file = file_reopen (area->file)) == NULL)
+			return false;
+		prev = area;
+		prev_copy = copy;
+	}
+	return spt_walk_range (src, NULL, (void *) KERN_BASE, spt_copy_page,
+			dst, false);
+}
+
+/* Returns a copy of SRC, a page at VA of a process being forked,
+ * that reads from the file of the area of DST holding VA, which the
+ * child owns.  Returns NULL if there is no such file or memory runs
+ * out. */
+static struct lazy_load_info *
+lazy_load_copy (struct supplemental_page_table *dst, void *va,
+		const struct lazy_load_info *src)
+{
+	struct vm_area *area = spt_find_area (dst, va);
+	struct lazy_load_info *copy;
+
+	if (area == NULL || area->file == NULL
+			|| (copy = malloc (sizeof *copy)) == NULL)
+		return NULL;
+	*copy = *src;
+	copy->file = area->file;
+	return copy;
+}
+
+/* Copies SRC_PAGE into DST, an spt being filled in by fork. */
+static bool
+spt_copy_page (struct page *src_page, void *dst_)
+{
+	struct supplemental_page_table *dst = dst_;
+
+	if (VM_TYPE(src_page->operations->type) == VM_UNINIT) {
+		void *aux = src_page->uninit.aux;
+
+		/* 실행 파일과 파일 매핑은 자식이 다시 연 파일에서 읽어야 한다.
+		   부모가 먼저 끝나면 부모의 파일은 닫힌다. */
+		if (src_page->uninit.init == lazy_load_segment
+				&& (aux = lazy_load_copy (dst, src_page->va, aux)) == NULL)
+			return false;
+		return vm_alloc_page_with_initializer(src_page->uninit.type, src_page->va, src_page->writable, src_page->uninit.init, aux);
 	}
+	if (src_page->operations->type == VM_ANON)
+	{
+		if (!vm_alloc_page(src_page->operations->type, src_page->va, src_page->writable))
+			return false;
+	}
+	else if (src_page->operations->type == VM_FILE)
+	{
+		struct lazy_load_info *aux = (struct lazy_load_info*)malloc(sizeof(struct lazy_load_info));
+		if (aux == NULL)
+			return false;
+		/* src initializer가 호출될 때 file_page 구조체 내에 저장해 둔 file/ofs/read_bytes를 꺼낸다. */
+		/* 자식 영역이 다시 연 파일을 쓴다. 부모가 munmap으로 닫아도 상관없다. */
+		aux->file = spt_find_area (dst, src_page->va)->file;
+		aux->ofs = src_page->file.file_ofs;
+		aux->page_read_bytes = src_page->file.read_bytes;
+
+		if (!vm_alloc_page_with_initializer(src_page->operations->type, src_page->va, src_page->writable, NULL, aux))
+			return false;
+	}
+	else
+		return true;
+
+	/* Share the parent's frame copy-on-write, bringing the page
+	   back first if it was evicted. */
+	struct page *dst_page = spt_find_page(dst, src_page->va);
+
+	dst_page->drop_behind = src_page->drop_behind;
+	while (!frame_share(src_page, dst_page)) {
+		if (src_page->frame != NULL || !vm_do_claim_page(src_page))
+			return false;
+	}
+
+	/* Text stays text, so the child drops it rather than swapping it
+	   out, and reloads it from its own executable.  So does a data
+	   page after MADV_DONTNEED. */
+	if (src_page->operations->type == VM_ANON && src_page->anon.text != NULL
+			&& (dst_page->anon.text = lazy_load_copy (dst, src_page->va,
+					src_page->anon.text)) == NULL)
+		return false;
+	if (src_page->operations->type == VM_ANON && src_page->anon.segment != NULL
+			&& (dst_page->anon.segment = lazy_load_copy (dst, src_page->va,
+					src_page->anon.segment)) == NULL)
+		return false;
 	return true;
 }
 
+/* Takes PAGE off its frame, for spt_destroy_range().  The caller
+ * must hold frame_lock. */
+static bool
+spt_unmap_page (struct page *page, void *aux UNUSED)
+{
+	frame_wait (page);
+	if (page->frame != NULL)
+		frame_put_page (page);
+	return true;
+}
 
-void destroy_hash_elem(struct hash_elem *e, void *aux) {
-	struct page *p = hash_entry(e, struct page, hash_elem);
-    destroy(p);
-	free(p);
+/* Destroys and frees PAGE, for spt_destroy_range(). */
+static bool
+spt_kill_page (struct page *page, void *aux UNUSED)
+{
+	destroy(page);
+	free(page);
+	return true;
+}
+
+/* Destroys and frees every page of SPT in [START, END).  All their
+ * frames are released first under a single hold of frame_lock, so
+ * destroy() finds nothing mapped and only has swap slots and
+ * compressed copies left to free.  Dirty file-backed pages must
+ * already have been written back.  If UNLINK is false the pages
+ * are left in the tree, for a caller that frees the whole tree
+ * next. */
+static void
+spt_destroy_range (struct supplemental_page_table *spt, void *start,
+		void *end, bool unlink)
+{
+	lock_acquire (&frame_lock);
+	spt_walk_range (spt, start, end, spt_unmap_page, NULL, false);
+	lock_release (&frame_lock);
+	spt_walk_range (spt, start, end, spt_kill_page, NULL, unlink);
+}
+
+/* Destroys every page of SPT in [START, END) and removes the areas
+ * that lie inside it, without writing anything back.  The files of
+ * removed areas are left open for the caller to close. */
+void
+spt_remove_range (struct supplemental_page_table *spt, void *start,
+		void *end)
+{
+	struct list_elem *e;
+
+	spt_destroy_range (spt, start, end, true);
+	for (e = list_begin (&spt->areas); e != list_end (&spt->areas); ) {
+		struct vm_area *area = list_entry (e, struct vm_area, elem);
+
+		e = list_next (e);
+		if (area->start >= end)
+			break;
+		if (area->start >= start && area->end <= end)
+			spt_remove_area (spt, area);
+	}
 }
 
 /* Free the resource hold by the supplemental page table */
@@ -358,5 +1728,344 @@ void supplemental_page_table_kill(struct supplemental_page_table *spt UNUSED)
 {
 	/* TODO: Destroy all the supplemental_page_table hold by thread and
 	 * TODO: writeback all the modified contents to the storage. */
-	hash_clear(&spt->pages, destroy_hash_elem);
-}
\ No newline at end of file
+	struct file *closed = NULL;
+	struct list_elem *e;
+
+	/* Write dirty mappings out in batches before tearing down. */
+	for (e = list_begin (&spt->areas); e != list_end (&spt->areas);
+			e = list_next (e)) {
+		struct vm_area *area = list_entry (e, struct vm_area, elem);
+		if (area->type == VM_FILE)
+			vm_writeback (spt, area->start, area->end);
+	}
+	spt_destroy_range (spt, NULL, (void *) KERN_BASE, false);
+	spt_free_nodes (spt->root, SPT_LEVELS - 1);
+	spt->root = NULL;
+
+	/* 매핑마다 연 파일을 닫는다.  쪼개진 영역은 파일 하나를 같이 쓴다. */
+	while (!list_empty (&spt->areas)) {
+		struct vm_area *area = list_entry (list_front (&spt->areas),
+				struct vm_area, elem);
+
+		if (area->type == VM_FILE && area->file != closed) {
+			closed = area->file;
+			file_close (closed);
+		}
+		spt_remove_area (spt, area);
+	}
+}
+/* Returns true if free frames are down to the low watermark. */
+static bool
+vm_frames_low (void)
+{
+	bool low;
+
+	lock_acquire (&frame_lock);
+	low = free_cnt <= free_low;
+	lock_release (&frame_lock);
+	return low;
+}
+
+/* Brings PAGE into memory ahead of use, for MADV_WILLNEED, if it is
+ * not there yet and has contents to read: from a file, the swap
+ * disk or the compressed swap cache.  Pages that would just be
+ * zeros are left alone. */
+static void
+vm_willneed_page (struct page *page)
+{
+	struct lazy_load_info *text = page_text (page);
+	struct file *file;
+	off_t ofs;
+	uint32_t read_bytes;
+	bool has_data, success;
+
+	if (page->frame != NULL)
+		return;
+	if (page_file_range (page, &file, &ofs, &read_bytes))
+		has_data = read_bytes > 0;
+	else
+		has_data = VM_TYPE (page->operations->type) == VM_ANON
+			&& !page_is_blank (page);
+	if (!has_data)
+		return;
+
+	if (text != NULL && vm_share_text_page (page, text))
+		return;
+	if (vm_fault_around (page, &success))
+		return;
+	if (text != NULL)
+		vm_claim_text_page (page, text);
+	else
+		vm_do_claim_page (page);
+}
+
+/* Drops the contents of PAGE, for MADV_DONTNEED, or if LAZY, lets
+ * eviction drop them unless PAGE is written first, for MADV_FREE.
+ * Dirty file pages are written back first.  Anonymous pages read
+ * back as zeros afterward, except pages of an executable segment,
+ * which are private copies of the file and are read from it again.
+ * MADV_FREE applies to anonymous memory only, so not to those. */
+static void
+vm_discard_page (struct page *page, bool lazy)
+{
+	enum vm_type type = VM_TYPE (page->operations->type);
+	struct frame *frame;
+	bool pinned;
+
+	if (type == VM_UNINIT
+			|| (lazy && (type != VM_ANON || page->anon.text != NULL
+					|| page->anon.segment != NULL)))
+		return;
+
+	lock_acquire (&frame_lock);
+	frame_wait (page);
+	frame = page->frame;
+	pinned = frame != NULL && frame->pin_cnt > 0;
+	lock_release (&frame_lock);
+	/* Frames being filled or copied are left alone, and so is the
+	   zero frame, which never holds anything to drop. */
+	if (pinned)
+		return;
+
+	if (lazy) {
+		if (frame != NULL) {
+			pml4_set_dirty (page->owner->pml4, page->va, false);
+			page->anon.lazy_free = true;
+		} else
+			anon_discard (page);
+		return;
+	}
+
+	if (type == VM_FILE && frame != NULL)
+		swap_out (page);
+	vm_free_frame (page);
+	if (type == VM_ANON) {
+		page->anon.lazy_free = false;
+		anon_discard (page);
+	}
+}
+
+/* Checks [ADDR, ADDR + LENGTH), the range given to madvise() or
+ * msync(): ADDR must be page-aligned, and every page in the range
+ * must belong to some area of SPT.  Returns the end of the range,
+ * rounded up to a page boundary, or NULL if it is bad. */
+static void *
+vm_user_range (struct supplemental_page_table *spt, void *addr,
+		size_t length)
+{
+	void *end, *va;
+
+	if (pg_ofs (addr) != 0 || !is_user_vaddr (addr))
+		return NULL;
+	if (length == 0)
+		return addr;
+	if (length >= KERN_BASE || !is_user_vaddr (addr + length - 1))
+		return NULL;
+	end = pg_round_up (addr + length);
+
+	for (va = addr; va < end; ) {
+		struct vm_area *area = spt_find_area (spt, va);
+		if (area == NULL)
+			return NULL;
+		va = area->end;
+	}
+	return end;
+}
+
+/* Applies ADVICE, one of the MADV_* values in <madvise.h>, to the
+ * pages of the current process in [ADDR, ADDR + LENGTH).  ADDR must
+ * be page-aligned, and every page in the range must belong to some
+ * area.  MADV_NORMAL, MADV_SEQUENTIAL and MADV_RANDOM are kept by
+ * the areas, which are split where the range ends inside one, and
+ * steer fault-around, swap readahead and eviction.  The others act
+ * on the range at once.  Returns false if the arguments are bad or
+ * memory runs out. */
+bool
+vm_madvise (void *addr, size_t length, int advice)
+{
+	struct supplemental_page_table *spt = &thread_current ()->spt;
+	void *end = vm_user_range (spt, addr, length);
+	void *va;
+
+	if (end == NULL || advice < MADV_NORMAL || advice > MADV_FREE)
+		return false;
+
+	switch (advice) {
+		case MADV_NORMAL:
+		case MADV_SEQUENTIAL:
+		case MADV_RANDOM:
+			for (va = addr; va < end; ) {
+				struct vm_area *area = spt_find_area (spt, va);
+
+				if (area->start < va
+						&& (area = spt_split_area (area, va)) == NULL)
+					return false;
+				if (end < area->end && spt_split_area (area, end) == NULL)
+					return false;
+				area->advice = advice;
+				area->ra_next = NULL;
+				area->ra_window = 0;
+				va = area->end;
+			}
+			for (va = addr; va < end; va += PGSIZE) {
+				struct page *page = spt_find_page (spt, va);
+				if (page != NULL)
+					page->drop_behind = advice == MADV_SEQUENTIAL;
+			}
+			break;
+
+		case MADV_WILLNEED:
+			/* Prefetching must not push other pages out. */
+			for (va = addr; va < end && !vm_frames_low (); va += PGSIZE) {
+				struct page *page = spt_find_page (spt, va);
+				if (page != NULL)
+					vm_willneed_page (page);
+			}
+			break;
+
+		case MADV_DONTNEED:
+		case MADV_FREE:
+			for (va = addr; va < end; va += PGSIZE) {
+				struct page *page = spt_find_page (spt, va);
+				if (page != NULL)
+					vm_discard_page (page, advice == MADV_FREE);
+			}
+			break;
+	}
+	return true;
+}
+
+/* If PAGE is a file-backed page with a dirty frame, clears the
+ * dirty bit, pins the frame, fills in WB for writing the page back
+ * and returns true.  Otherwise returns false.  A write to PAGE while
+ * the writeback is under way dirties it again.  The caller must
+ * hold frame_lock. */
+static bool
+flush_queue (struct page *page, struct file_wb *wb)
+{
+	struct frame *frame = page->frame;
+
+	ASSERT (lock_held_by_current_thread (&frame_lock));
+
+	if (VM_TYPE (page->operations->type) != VM_FILE || frame == NULL
+			|| frame->evicting || page->file.read_bytes == 0
+			|| !pml4_is_dirty (page->owner->pml4, page->va))
+		return false;
+	pml4_set_dirty (page->owner->pml4, page->va, false);
+	frame->pin_cnt++;
+	wb->inode = inode_reopen (file_get_inode (page->file.file));
+	wb->ofs = page->file.file_ofs;
+	wb->len = page->file.read_bytes;
+	wb->frame = frame;
+	return true;
+}
+
+/* Writes back the CNT pages queued in WB by flush_queue(), then
+ * unpins their frames. */
+static void
+flush_batch (struct file_wb *wb, size_t cnt)
+{
+	size_t i;
+
+	file_backed_writeback (wb, cnt);
+	lock_acquire (&frame_lock);
+	for (i = 0; i < cnt; i++) {
+		wb[i].frame->pin_cnt--;
+		frame_release (wb[i].frame);
+	}
+	lock_release (&frame_lock);
+	for (i = 0; i < cnt; i++)
+		inode_close (wb[i].inode);
+}
+
+/* Flusher daemon.  Sweeps the whole frame table every
+ * FLUSH_INTERVAL ticks and writes back every dirty file-backed page
+ * it finds. */
+static void
+flush_daemon (void *aux UNUSED)
+{
+	struct file_wb wb[FILE_WB_BATCH];
+
+	for (;;) {
+		size_t i = 0;
+
+		timer_sleep (FLUSH_INTERVAL);
+		while (i < frame_cnt) {
+			size_t cnt = 0;
+
+			lock_acquire (&frame_lock);
+			for (; i < frame_cnt && cnt < FILE_WB_BATCH; i++) {
+				struct frame *f = &frame_table[i];
+
+				if (f->share_cnt == 0 || f->pin_cnt > 0 || f->evicting)
+					continue;
+				for (struct list_elem *e = list_begin (&f->pages);
+						e != list_end (&f->pages) && cnt < FILE_WB_BATCH;
+						e = list_next (e))
+					if (flush_queue (list_entry (e, struct page, share_elem),
+								&wb[cnt]))
+						cnt++;
+			}
+			lock_release (&frame_lock);
+			if (cnt > 0)
+				flush_batch (wb, cnt);
+		}
+	}
+}
+
+/* Pages queued by vm_writeback() but not yet written. */
+struct writeback {
+	struct file_wb wb[FILE_WB_BATCH];
+	size_t cnt;
+};
+
+/* Queues PAGE in WB_ if it is dirty and file-backed, writing the
+ * batch out once it is full.  For vm_writeback(). */
+static bool
+writeback_page (struct page *page, void *wb_)
+{
+	struct writeback *wb = wb_;
+	bool queued;
+
+	if (VM_TYPE (page->operations->type) != VM_FILE || page->frame == NULL)
+		return true;
+	lock_acquire (&frame_lock);
+	frame_wait (page);
+	queued = flush_queue (page, &wb->wb[wb->cnt]);
+	lock_release (&frame_lock);
+	if (queued && ++wb->cnt == FILE_WB_BATCH) {
+		flush_batch (wb->wb, wb->cnt);
+		wb->cnt = 0;
+	}
+	return true;
+}
+
+/* Writes back every dirty file-backed page of SPT in
+ * [START, END), FILE_WB_BATCH pages at a time, each batch sorted by
+ * file and offset.  Returns once the data is on disk. */
+void
+vm_writeback (struct supplemental_page_table *spt, void *start, void *end)
+{
+	struct writeback wb;
+
+	wb.cnt = 0;
+	spt_walk_range (spt, start, end, writeback_page, &wb, false);
+	if (wb.cnt > 0)
+		flush_batch (wb.wb, wb.cnt);
+}
+
+/* Writes back the dirty file-backed pages of the current process
+ * in [ADDR, ADDR + LENGTH).  ADDR must be page-aligned, and every
+ * page in the range must belong to some area.  Returns false if
+ * the arguments are bad. */
+bool
+vm_msync (void *addr, size_t length)
+{
+	struct supplemental_page_table *spt = &thread_current ()->spt;
+	void *end = vm_user_range (spt, addr, length);
+
+	if (end == NULL)
+		return false;
+	vm_writeback (spt, addr, end);
+	return true;
+}